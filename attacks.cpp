@@ -0,0 +1,118 @@
+// attacks.cpp
+#include <bit>
+#include <vector>
+
+#include "attacks.h"
+#include "bitboard.h"
+
+MagicTables magicTables;
+LineTables lineTables;
+
+uint64_t slidingAttacks(int sq, uint64_t occupied, bool diagonal)
+{
+    static const int rookSteps[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    static const int bishopSteps[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+    uint64_t attacks = 0;
+    for (const auto& step : diagonal ? bishopSteps : rookSteps) {
+        int file = sq % 8 + step[0];
+        int rank = sq / 8 + step[1];
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            uint64_t bit = 1ULL << (rank * 8 + file);
+            attacks |= bit;
+            if (occupied & bit)
+                break;
+            file += step[0];
+            rank += step[1];
+        }
+    }
+    return attacks;
+}
+
+// Finds a magic for every square by trial with sparse random numbers. The
+// per-rank seeds are known to converge quickly, and being fixed they give the
+// same tables on every run.
+static void initMagics(std::array<Magic, 64>& magics, uint64_t* table, bool diagonal)
+{
+    static const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+    uint64_t seed = 0;
+    auto random = [&seed]()
+        {
+            seed ^= seed >> 12;
+            seed ^= seed << 25;
+            seed ^= seed >> 27;
+            return seed * 2685821657736338717ULL;
+        };
+
+    std::vector<uint64_t> occupancy(4096), reference(4096);
+    std::vector<int> epoch(4096, 0);
+    int attempt = 0;
+
+    uint64_t* next = table;
+    for (int sq = 0; sq < 64; ++sq) {
+        uint64_t rank = RANK_1 << (8 * (sq / 8));
+        uint64_t file = FILE_A << (sq % 8);
+        uint64_t edges = ((RANK_1 | RANK_8) & ~rank) | ((FILE_A | FILE_H) & ~file);
+
+        Magic& m = magics[sq];
+        m.mask = slidingAttacks(sq, 0, diagonal) & ~edges;
+        m.shift = 64 - std::popcount(m.mask);
+        m.attacks = next;
+
+        // Enumerate every subset of the mask (carry-rippler)
+        int size = 0;
+        uint64_t subset = 0;
+        do {
+            occupancy[size] = subset;
+            reference[size] = slidingAttacks(sq, subset, diagonal);
+            ++size;
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+        next += size;
+        seed = seeds[sq / 8];
+
+        // The epoch marks which slots were written by the current candidate,
+        // so the table does not need clearing between attempts.
+        for (int i = 0; i < size; ) {
+            do {
+                m.magic = random() & random() & random();
+            } while (std::popcount((m.magic * m.mask) >> 56) < 6);
+
+            ++attempt;
+            for (i = 0; i < size; ++i) {
+                unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                }
+                else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+MagicTables::MagicTables()
+{
+    initMagics(rook, rookTable.data(), false);
+    initMagics(bishop, bishopTable.data(), true);
+}
+
+LineTables::LineTables()
+{
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            between[a][b] = 0;
+            line[a][b] = 0;
+            for (bool diagonal : { false, true }) {
+                if (!(slidingAttacks(a, 0, diagonal) & (1ULL << b)))
+                    continue;
+                between[a][b] = slidingAttacks(a, 1ULL << b, diagonal) & slidingAttacks(b, 1ULL << a, diagonal);
+                line[a][b] = (slidingAttacks(a, 0, diagonal) & slidingAttacks(b, 0, diagonal))
+                    | (1ULL << a) | (1ULL << b);
+            }
+        }
+    }
+}
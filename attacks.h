@@ -0,0 +1,153 @@
+// attacks.h
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "bitboard.h"
+#include "chesstypes.h"
+
+constexpr uint64_t kingAttackMask(int sq)
+{
+    int file = sq % 8;
+    int rank = sq / 8;
+    uint64_t attacks = 0ULL;
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int df = -1; df <= 1; ++df) {
+            if (dr == 0 && df == 0) continue;
+            int r = rank + dr;
+            int f = file + df;
+            if (r >= 0 && r <= 7 && f >= 0 && f <= 7) {
+                attacks |= 1ULL << (r * 8 + f);
+            }
+        }
+    }
+    return attacks;
+}
+
+constexpr std::array<uint64_t, 64> makeKingAttacks()
+{
+    std::array<uint64_t, 64> arr = {};
+    for (int sq = 0; sq < 64; ++sq)
+        arr[sq] = kingAttackMask(sq);
+    return arr;
+}
+
+constexpr std::array<uint64_t, 64> KING_ATTACKS = makeKingAttacks();
+
+// Set-wise knight attacks of every knight in the bitboard
+constexpr uint64_t knightAttacks(uint64_t knights)
+{
+    uint64_t l1 = (knights >> 1) & 0x7f7f7f7f7f7f7f7fULL;
+    uint64_t l2 = (knights >> 2) & 0x3f3f3f3f3f3f3f3fULL;
+    uint64_t r1 = (knights << 1) & 0xfefefefefefefefeULL;
+    uint64_t r2 = (knights << 2) & 0xfcfcfcfcfcfcfcfcULL;
+
+    uint64_t h1 = l1 | r1;
+    uint64_t h2 = l2 | r2;
+
+    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+constexpr std::array<uint64_t, 64> makeKnightAttacks()
+{
+    std::array<uint64_t, 64> arr = {};
+    for (int sq = 0; sq < 64; ++sq)
+        arr[sq] = knightAttacks(1ULL << sq);
+    return arr;
+}
+
+constexpr std::array<uint64_t, 64> KNIGHT_ATTACKS = makeKnightAttacks();
+
+// Set-wise diagonal attacks of every pawn in the bitboard
+constexpr uint64_t pawnAttacks(uint64_t pawns, Color side)
+{
+    return (side == Color::White)
+        ? ((pawns << 7) & ~FILE_H) | ((pawns << 9) & ~FILE_A)
+        : ((pawns >> 7) & ~FILE_A) | ((pawns >> 9) & ~FILE_H);
+}
+
+constexpr std::array<std::array<uint64_t, 64>, 2> makePawnAttacks()
+{
+    std::array<std::array<uint64_t, 64>, 2> arr = {};
+    for (int sq = 0; sq < 64; ++sq) {
+        arr[0][sq] = pawnAttacks(1ULL << sq, Color::White);
+        arr[1][sq] = pawnAttacks(1ULL << sq, Color::Black);
+    }
+    return arr;
+}
+
+// [0] white, [1] black
+constexpr std::array<std::array<uint64_t, 64>, 2> PAWN_ATTACKS = makePawnAttacks();
+
+// Magic bitboard lookup for sliding pieces. The relevant blockers of a square
+// are multiplied by a magic number so that the top bits form a unique index
+// into that square's slice of the attack table.
+struct Magic {
+    uint64_t mask = 0;       // relevant occupancy, board edges excluded
+    uint64_t magic = 0;
+    uint64_t* attacks = nullptr;
+    unsigned shift = 0;
+
+    unsigned index(uint64_t occupied) const
+    {
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+    }
+};
+
+struct MagicTables {
+    static constexpr int ROOK_TABLE_SIZE = 0x19000;  // sum of 2^bits over all squares
+    static constexpr int BISHOP_TABLE_SIZE = 0x1480;
+
+    std::array<Magic, 64> rook;
+    std::array<Magic, 64> bishop;
+    std::array<uint64_t, ROOK_TABLE_SIZE> rookTable;
+    std::array<uint64_t, BISHOP_TABLE_SIZE> bishopTable;
+
+    MagicTables();
+};
+
+// Built once at startup, before main() runs.
+extern MagicTables magicTables;
+
+// Reference attack generator used to fill the tables, walking each ray until
+// it leaves the board or hits a blocker.
+uint64_t slidingAttacks(int sq, uint64_t occupied, bool diagonal);
+
+inline uint64_t rookAttacks(int sq, uint64_t occupied)
+{
+    const Magic& m = magicTables.rook[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline uint64_t bishopAttacks(int sq, uint64_t occupied)
+{
+    const Magic& m = magicTables.bishop[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline uint64_t queenAttacks(int sq, uint64_t occupied)
+{
+    return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied);
+}
+
+// Squares strictly between two squares on a shared rank, file or diagonal,
+// and the full line through them. Both are empty for unaligned squares.
+struct LineTables {
+    std::array<std::array<uint64_t, 64>, 64> between;
+    std::array<std::array<uint64_t, 64>, 64> line;
+
+    LineTables();
+};
+
+extern LineTables lineTables;
+
+inline uint64_t betweenSquares(int a, int b)
+{
+    return lineTables.between[a][b];
+}
+
+inline uint64_t lineThrough(int a, int b)
+{
+    return lineTables.line[a][b];
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <bitset>
 
@@ -10,3 +12,9 @@ constexpr uint64_t RANK_2 = 0x000000000000FF00ULL;
 constexpr uint64_t RANK_7 = 0x00FF000000000000ULL;
 constexpr uint64_t RANK_8 = 0xFF00000000000000ULL;
 
+// Largest power of two no greater than n, and never below one. Hash tables
+// take their size from this so the index is a mask of the key.
+constexpr size_t floorPow2(size_t n)
+{
+    return n > 1 ? std::bit_floor(n) : 1;
+}
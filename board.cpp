@@ -2,7 +2,9 @@
 #include <bitset>
 #include <algorithm>
 #include <assert.h>
+#include <sstream>
 
+#include "attacks.h"
 #include "bitboard.h"
 #include "board.h"
 #include "fen.h"
@@ -10,54 +12,8 @@
 #include "zobrist.h"
 #include <unordered_map>
 
-extern Fen fen;
 extern Zobrist zobrist;
 
-constexpr uint64_t kingAttackMask(int sq)
-{
-    int file = sq % 8;
-    int rank = sq / 8;
-    uint64_t attacks = 0ULL;
-    for (int dr = -1; dr <= 1; ++dr) {
-        for (int df = -1; df <= 1; ++df) {
-            if (dr == 0 && df == 0) continue;
-            int r = rank + dr;
-            int f = file + df;
-            if (r >= 0 && r <= 7 && f >= 0 && f <= 7) {
-                attacks |= 1ULL << (r * 8 + f);
-            }
-        }
-    }
-    return attacks;
-}
-
-constexpr std::array<uint64_t, 64> makeKingAttacks()
-{
-    std::array<uint64_t, 64> arr = {};
-    for (int sq = 0; sq < 64; ++sq)
-        arr[sq] = kingAttackMask(sq);
-    return arr;
-}
-
-constexpr std::array<uint64_t, 64> KING_ATTACKS = makeKingAttacks();
-
-inline static uint64_t knightAttacks(uint64_t knights)
-{
-    uint64_t l1 = (knights >> 1) & 0x7f7f7f7f7f7f7f7fULL;
-    uint64_t l2 = (knights >> 2) & 0x3f3f3f3f3f3f3f3fULL;
-    uint64_t r1 = (knights << 1) & 0xfefefefefefefefeULL;
-    uint64_t r2 = (knights << 2) & 0xfcfcfcfcfcfcfcfcULL;
-
-    uint64_t h1 = l1 | r1;
-    uint64_t h2 = l2 | r2;
-
-    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
-}
-
-std::vector<int> rookDirections = { 8, -8, 1, -1 };
-std::vector<int> bishopDirections = { 9, 7, -7, -9 };
-std::vector<int> queenDirections = { 8, -8, 1, -1, 9, 7, -7, -9 };
-
 Board::Board()
 {
     reset();
@@ -78,9 +34,11 @@ std::string Board::toString() const
     return oss.str();
 }
 
-Board::Board(std::string fen)
+Board::Board(std::string_view fen)
 {
     moveHistory.clear();
+    keyHistory.clear();
+    nullBarrier = 0;
     whiteKingside = false;
     whiteQueenside = false;
     blackKingside = false;
@@ -92,9 +50,58 @@ Board::Board(std::string fen)
     loadFEN(fen);
 }
 
+Board::Board(const Position& position)
+    : Position(position)
+{
+}
+
+void Board::setPosition(const Position& position)
+{
+    Position::operator=(position);
+    moveHistory.clear();
+    keyHistory.clear();
+    nullBarrier = 0;
+}
+
+void Board::setPosition(const Position& position, const std::vector<uint64_t>& keys)
+{
+    setPosition(position);
+    keyHistory = keys;
+}
+
+bool Board::isRepetition() const
+{
+    // Only positions since the last capture, pawn move or null move can come
+    // back, and only those with the same side to move
+    int count = static_cast<int>(keyHistory.size());
+    int reversible = std::min(halfMoveClock, count - nullBarrier);
+    for (int back = 4; back <= reversible; back += 2) {
+        if (keyHistory[count - back] == hashKey)
+            return true;
+    }
+    return false;
+}
+
+bool Board::isDraw() const
+{
+    if (isRepetition())
+        return true;
+    if (halfMoveClock < 100)
+        return false;
+
+    // Mate on the hundredth reversible move still wins
+    if (!isInCheck(turn))
+        return true;
+    MoveList moves;
+    generateFullyLegalMoves(turn, moves);
+    return !moves.empty();
+}
+
 void Board::reset()
 {
     moveHistory.clear();
+    keyHistory.clear();
+    nullBarrier = 0;
     whiteKingside = false;
     whiteQueenside = false;
     blackKingside = false;
@@ -106,7 +113,7 @@ void Board::reset()
     loadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 }
 
-uint64_t Board::zobristHash() const
+uint64_t Board::computeZobristHash() const
 {
     uint64_t hash = 0;
 
@@ -115,10 +122,7 @@ uint64_t Board::zobristHash() const
         for (int x = 0; x < 8; ++x) {
             Piece p = get(x, y);
             if (p.type == PieceType::None) continue;
-            int pt = static_cast<int>(p.type) - 1; // Assuming Pawn=1, ..., King=6
-            int color = (p.color == Color::White) ? 0 : 1;
-            int sq = y * 8 + x;
-            hash ^= zobrist.pieceSquare[pt][color][sq];
+            hash ^= pieceHash(p.type, p.color, y * 8 + x);
         }
     }
 
@@ -126,20 +130,108 @@ uint64_t Board::zobristHash() const
     if (turn == Color::Black)
         hash ^= zobrist.sideToMove;
 
-    // Castling rights
+    return hash ^ castlingHash() ^ enPassantHash();
+}
+
+uint64_t Board::computePawnHash() const
+{
+    uint64_t hash = 0;
+    for (uint64_t bb = white_pawns; bb; bb &= bb - 1)
+        hash ^= pieceHash(PieceType::Pawn, Color::White, std::countr_zero(bb));
+    for (uint64_t bb = black_pawns; bb; bb &= bb - 1)
+        hash ^= pieceHash(PieceType::Pawn, Color::Black, std::countr_zero(bb));
+    return hash;
+}
+
+uint64_t Board::keyAfter(PackedMove move) const
+{
+    int from = move.from();
+    int to = move.to();
+    Piece moving = pieceOn(from);
+    Piece captured = pieceOn(to);
+
+    uint64_t key = hashKey ^ zobrist.sideToMove ^ enPassantHash()
+        ^ pieceHash(moving.type, moving.color, from)
+        ^ pieceHash(moving.type, moving.color, to);
+    if (captured.type != PieceType::None)
+        key ^= pieceHash(captured.type, captured.color, to);
+    return key;
+}
+
+void Board::addPieceScore(PieceType type, Color color, int sq)
+{
+    int c = (color == Color::White) ? 0 : 1;
+    materialScore[c] += PIECE_SCORE[static_cast<int>(type)];
+    pstScore[c] += pieceSquareScore(type, color, sq);
+    phase += PHASE_WEIGHT[static_cast<int>(type)];
+}
+
+void Board::removePieceScore(PieceType type, Color color, int sq)
+{
+    int c = (color == Color::White) ? 0 : 1;
+    materialScore[c] -= PIECE_SCORE[static_cast<int>(type)];
+    pstScore[c] -= pieceSquareScore(type, color, sq);
+    phase -= PHASE_WEIGHT[static_cast<int>(type)];
+}
+
+void Board::computeEvalScores(std::array<Score, 2>& material, std::array<Score, 2>& pst, int& gamePhase) const
+{
+    material = {};
+    pst = {};
+    gamePhase = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        Piece p = pieceOn(sq);
+        if (p.type == PieceType::None)
+            continue;
+        int c = (p.color == Color::White) ? 0 : 1;
+        material[c] += PIECE_SCORE[static_cast<int>(p.type)];
+        pst[c] += pieceSquareScore(p.type, p.color, sq);
+        gamePhase += PHASE_WEIGHT[static_cast<int>(p.type)];
+    }
+}
+
+bool Board::evalScoresMatch() const
+{
+    std::array<Score, 2> material, pst;
+    int gamePhase;
+    computeEvalScores(material, pst, gamePhase);
+    return material == materialScore && pst == pstScore && gamePhase == phase;
+}
+
+uint64_t Board::pieceHash(PieceType type, Color color, int sq) const
+{
+    int pt = static_cast<int>(type) - 1; // Pawn=1, ..., King=6
+    int c = (color == Color::White) ? 0 : 1;
+    return zobrist.pieceSquare[pt][c][sq];
+}
+
+uint64_t Board::castlingHash() const
+{
+    uint64_t hash = 0;
     if (whiteKingside)  hash ^= zobrist.castlingRights[0];
     if (whiteQueenside) hash ^= zobrist.castlingRights[1];
     if (blackKingside)  hash ^= zobrist.castlingRights[2];
     if (blackQueenside) hash ^= zobrist.castlingRights[3];
+    return hash;
+}
 
-    // En passant
+uint64_t Board::enPassantHash() const
+{
     if (enPassantTarget.x >= 0 && enPassantTarget.x < 8 &&
         ((turn == Color::White && enPassantTarget.y == 5) ||
             (turn == Color::Black && enPassantTarget.y == 2))) {
-        hash ^= zobrist.enPassantFile[enPassantTarget.x];
+        return zobrist.enPassantFile[enPassantTarget.x];
     }
+    return 0;
+}
 
-    return hash;
+void Board::setTurn(Color side)
+{
+    if (turn != side) {
+        hashKey ^= enPassantHash();
+        turn = side;
+        hashKey ^= zobrist.sideToMove ^ enPassantHash();
+    }
 }
 
 bool Board::isInside(int x, int y) const
@@ -149,7 +241,12 @@ bool Board::isInside(int x, int y) const
 
 const Piece Board::get(int x, int y) const
 {
-    uint64_t mask = 1ULL << (y * 8 + x);
+    return pieceOn(y * 8 + x);
+}
+
+Piece Board::pieceFromBitboards(int sq) const
+{
+    uint64_t mask = 1ULL << sq;
     Color color = Color::White;
     PieceType piecetype = PieceType::None;
 
@@ -183,12 +280,32 @@ const Piece Board::get(int x, int y) const
     return Piece{ piecetype, color };
 }
 
+bool Board::mailboxMatches() const
+{
+    for (int sq = 0; sq < 64; ++sq) {
+        Piece p = pieceFromBitboards(sq);
+        if (mailbox[sq] != (p.type == PieceType::None ? 0 : pieceCode(p.type, p.color)))
+            return false;
+    }
+    return true;
+}
+
 void Board::makeMove(const Move& move)
 {
-    Piece movedPiece = get(move.from.x, move.from.y);
+    makeMove(PackedMove(move));
+}
+
+void Board::makeMove(PackedMove move)
+{
+    int fromIndex = move.from();
+    int toIndex = move.to();
+    uint64_t fromBB = 1ULL << fromIndex;
+    uint64_t toBB = 1ULL << toIndex;
+
+    Piece movedPiece = pieceOn(fromIndex);
     if (movedPiece.type == PieceType::None) {
-        std::cerr << "makeMove: No piece at from-square (" << move.from.x << "," << move.from.y << ") for move: "
-            << move.from.toString() << std::endl;
+        std::cerr << "makeMove: No piece at from-square (" << fromIndex % 8 << "," << fromIndex / 8 << ") for move: "
+            << move.toString() << std::endl;
         std::cerr << "Board state:\n" << toString() << std::endl;
         throw std::runtime_error("makeMove: No piece at from-square");
     }
@@ -203,17 +320,22 @@ void Board::makeMove(const Move& move)
     state.enPassantTarget = enPassantTarget;
     state.halfMoveClock = halfMoveClock;
     state.fullMoveNumber = fullMoveNumber;
+    state.hashKey = hashKey;
+    state.pawnKey = pawnKey;
+    state.nullBarrier = nullBarrier;
+    state.material = materialScore;
+    state.pst = pstScore;
+    state.phase = phase;
+
+    // Castling and en passant keys are taken out here and put back once the
+    // new rights and target are known.
+    uint64_t key = hashKey ^ castlingHash() ^ enPassantHash();
 
     // Clear en passant target
     enPassantTarget = Square{ -1, -1 };
 
-    int fromIndex = move.from.y * 8 + move.from.x;
-    int toIndex = move.to.y * 8 + move.to.x;
-    uint64_t fromBB = 1ULL << fromIndex;
-    uint64_t toBB = 1ULL << toIndex;
-
     // Handle captures (including en passant)
-    if (move.type == MoveType::EnPassant) {
+    if (move.isEnPassant()) {
         // For en passant, the captured pawn is in a different square
         int capturedPawnIndex = (turn == Color::White) ? toIndex - 8 : toIndex + 8;
         uint64_t capturedBB = 1ULL << capturedPawnIndex;
@@ -224,27 +346,41 @@ void Board::makeMove(const Move& move)
         else {
             white_pawns &= ~capturedBB;
         }
+        mailbox[capturedPawnIndex] = 0;
         state.captured = Piece{ PieceType::Pawn, opposite(turn) };
+        key ^= pieceHash(PieceType::Pawn, opposite(turn), capturedPawnIndex);
+        pawnKey ^= pieceHash(PieceType::Pawn, opposite(turn), capturedPawnIndex);
+        removePieceScore(PieceType::Pawn, opposite(turn), capturedPawnIndex);
     }
     else {
         // Regular capture
-        state.captured = get(move.to.x, move.to.y);
+        state.captured = pieceOn(toIndex);
         if (state.captured.type != PieceType::None) {
             uint64_t& pieceBB = getPieceBB(state.captured.type, state.captured.color);
             pieceBB &= ~toBB;
+            key ^= pieceHash(state.captured.type, state.captured.color, toIndex);
+            if (state.captured.type == PieceType::Pawn)
+                pawnKey ^= pieceHash(PieceType::Pawn, state.captured.color, toIndex);
+            removePieceScore(state.captured.type, state.captured.color, toIndex);
         }
     }
 
     // Handle castling
-    if (move.type == MoveType::Castle) {
+    if (move.isCastle()) {
         // Move the rook
-        if (move.to.x == 6) { // Kingside
+        if (move.flags() == PackedMove::KingCastle) {
             uint64_t rookFromBB = turn == Color::White ? 0x80 : 0x8000000000000000;
             uint64_t rookToBB = turn == Color::White ? 0x20 : 0x2000000000000000;
 
             uint64_t& rooks = turn == Color::White ? white_rooks : black_rooks;
             rooks &= ~rookFromBB;
             rooks |= rookToBB;
+            key ^= pieceHash(PieceType::Rook, turn, std::countr_zero(rookFromBB)) ^
+                pieceHash(PieceType::Rook, turn, std::countr_zero(rookToBB));
+            removePieceScore(PieceType::Rook, turn, std::countr_zero(rookFromBB));
+            addPieceScore(PieceType::Rook, turn, std::countr_zero(rookToBB));
+            mailbox[std::countr_zero(rookFromBB)] = 0;
+            mailbox[std::countr_zero(rookToBB)] = pieceCode(PieceType::Rook, turn);
         }
         else { // Queenside
             uint64_t rookFromBB = turn == Color::White ? 0x1 : 0x100000000000000;
@@ -253,21 +389,41 @@ void Board::makeMove(const Move& move)
             uint64_t& rooks = turn == Color::White ? white_rooks : black_rooks;
             rooks &= ~rookFromBB;
             rooks |= rookToBB;
+            key ^= pieceHash(PieceType::Rook, turn, std::countr_zero(rookFromBB)) ^
+                pieceHash(PieceType::Rook, turn, std::countr_zero(rookToBB));
+            removePieceScore(PieceType::Rook, turn, std::countr_zero(rookFromBB));
+            addPieceScore(PieceType::Rook, turn, std::countr_zero(rookToBB));
+            mailbox[std::countr_zero(rookFromBB)] = 0;
+            mailbox[std::countr_zero(rookToBB)] = pieceCode(PieceType::Rook, turn);
         }
     }
 
     // Move the piece
     uint64_t& pieceBB = getPieceBB(movedPiece.type, movedPiece.color);
     pieceBB &= ~fromBB;
+    key ^= pieceHash(movedPiece.type, movedPiece.color, fromIndex);
+    removePieceScore(movedPiece.type, movedPiece.color, fromIndex);
+    mailbox[fromIndex] = 0;
+    if (movedPiece.type == PieceType::Pawn) {
+        pawnKey ^= pieceHash(PieceType::Pawn, movedPiece.color, fromIndex);
+        if (!move.isPromotion())
+            pawnKey ^= pieceHash(PieceType::Pawn, movedPiece.color, toIndex);
+    }
 
     // Handle promotion
-    if (move.type == MoveType::Promotion) {
-        PieceType promotedType = move.promotionType;
+    if (move.isPromotion()) {
+        PieceType promotedType = move.promotionType();
         uint64_t& promotedBB = getPieceBB(promotedType, movedPiece.color);
         promotedBB |= toBB;
+        key ^= pieceHash(promotedType, movedPiece.color, toIndex);
+        addPieceScore(promotedType, movedPiece.color, toIndex);
+        mailbox[toIndex] = pieceCode(promotedType, movedPiece.color);
     }
     else {
         pieceBB |= toBB;
+        key ^= pieceHash(movedPiece.type, movedPiece.color, toIndex);
+        addPieceScore(movedPiece.type, movedPiece.color, toIndex);
+        mailbox[toIndex] = pieceCode(movedPiece.type, movedPiece.color);
     }
 
     // Update castling rights if rook or king moves
@@ -283,18 +439,26 @@ void Board::makeMove(const Move& move)
     }
     else if (movedPiece.type == PieceType::Rook) {
         if (turn == Color::White) {
-            if (move.from.x == 0 && move.from.y == 0) whiteQueenside = false;
-            if (move.from.x == 7 && move.from.y == 0) whiteKingside = false;
+            if (fromIndex == 0) whiteQueenside = false;
+            if (fromIndex == 7) whiteKingside = false;
         }
         else {
-            if (move.from.x == 0 && move.from.y == 7) blackQueenside = false;
-            if (move.from.x == 7 && move.from.y == 7) blackKingside = false;
+            if (fromIndex == 56) blackQueenside = false;
+            if (fromIndex == 63) blackKingside = false;
         }
     }
 
+    // A rook captured on its home square takes its castling right with it
+    if (state.captured.type == PieceType::Rook) {
+        if (toIndex == 0)  whiteQueenside = false;
+        if (toIndex == 7)  whiteKingside = false;
+        if (toIndex == 56) blackQueenside = false;
+        if (toIndex == 63) blackKingside = false;
+    }
+
     // Set en passant target for double pawn push
-    if (movedPiece.type == PieceType::Pawn && abs(move.to.y - move.from.y) == 2) {
-        enPassantTarget = Square{ move.from.x, (move.from.y + move.to.y) / 2 };
+    if (movedPiece.type == PieceType::Pawn && abs(toIndex - fromIndex) == 16) {
+        enPassantTarget = Square{ fromIndex % 8, (fromIndex + toIndex) / 16 };
     }
 
     // Update move clocks
@@ -314,9 +478,50 @@ void Board::makeMove(const Move& move)
 
     // Switch turns
     turn = opposite(turn);
+    hashKey = key ^ zobrist.sideToMove ^ castlingHash() ^ enPassantHash();
+    assert(mailboxMatches());
+    assert(hashKey == computeZobristHash());
+    assert(pawnKey == computePawnHash());
+    assert(evalScoresMatch());
 
     // Save state for undo
     moveHistory.push_back(state);
+    keyHistory.push_back(state.hashKey);
+}
+
+void Board::makeNullMove()
+{
+    BoardState state;
+    state.move = PackedMove{};
+    state.captured = Piece{};
+    state.whiteKingside = whiteKingside;
+    state.whiteQueenside = whiteQueenside;
+    state.blackKingside = blackKingside;
+    state.blackQueenside = blackQueenside;
+    state.enPassantTarget = enPassantTarget;
+    state.halfMoveClock = halfMoveClock;
+    state.fullMoveNumber = fullMoveNumber;
+    state.hashKey = hashKey;
+    state.pawnKey = pawnKey;
+    state.nullBarrier = nullBarrier;
+    state.material = materialScore;
+    state.pst = pstScore;
+    state.phase = phase;
+
+    hashKey ^= enPassantHash();
+    enPassantTarget = Square{ -1, -1 };
+    halfMoveClock++;
+    if (turn == Color::Black)
+        fullMoveNumber++;
+    turn = opposite(turn);
+    hashKey ^= zobrist.sideToMove;
+    assert(hashKey == computeZobristHash());
+
+    moveHistory.push_back(state);
+    keyHistory.push_back(state.hashKey);
+    // Positions before a null move are not repeated by the moves after it,
+    // so the repetition scan stops here
+    nullBarrier = static_cast<int>(keyHistory.size());
 }
 
 void Board::undoMove()
@@ -326,42 +531,60 @@ void Board::undoMove()
 
     const BoardState& state = moveHistory.back();
 
+    // A null move only changed the side to move and the counters
+    if (state.move.isNull()) {
+        turn = opposite(turn);
+        enPassantTarget = state.enPassantTarget;
+        halfMoveClock = state.halfMoveClock;
+        fullMoveNumber = state.fullMoveNumber;
+        hashKey = state.hashKey;
+        nullBarrier = state.nullBarrier;
+        moveHistory.pop_back();
+        keyHistory.pop_back();
+        return;
+    }
+
     // Switch turns back
     turn = opposite(turn);
 
-    int fromIndex = state.move.from.y * 8 + state.move.from.x;
-    int toIndex = state.move.to.y * 8 + state.move.to.x;
+    int fromIndex = state.move.from();
+    int toIndex = state.move.to();
     uint64_t fromBB = 1ULL << fromIndex;
     uint64_t toBB = 1ULL << toIndex;
 
     // Undo the piece movement
-    Piece movedPiece = get(state.move.to.x, state.move.to.y); // Get the piece at destination
+    Piece movedPiece = pieceOn(toIndex); // Get the piece at destination
 
     // Handle promotion undo
-    if (state.move.type == MoveType::Promotion) {
-        uint64_t& promotedBB = getPieceBB(state.move.promotionType, movedPiece.color);
+    if (state.move.isPromotion()) {
+        uint64_t& promotedBB = getPieceBB(state.move.promotionType(), movedPiece.color);
         promotedBB &= ~toBB;
 
         // Restore pawn
         uint64_t& pawnBB = getPieceBB(PieceType::Pawn, movedPiece.color);
         pawnBB |= fromBB;
+        mailbox[fromIndex] = pieceCode(PieceType::Pawn, movedPiece.color);
     }
     else {
         uint64_t& pieceBB = getPieceBB(movedPiece.type, movedPiece.color);
         pieceBB &= ~toBB;
         pieceBB |= fromBB;
+        mailbox[fromIndex] = pieceCode(movedPiece.type, movedPiece.color);
     }
+    mailbox[toIndex] = 0;
 
     // Handle castling undo
-    if (state.move.type == MoveType::Castle) {
+    if (state.move.isCastle()) {
         // Move the rook back
-        if (state.move.to.x == 6) { // Kingside
+        if (state.move.flags() == PackedMove::KingCastle) {
             uint64_t rookFromBB = turn == Color::White ? 0x20 : 0x2000000000000000;
             uint64_t rookToBB = turn == Color::White ? 0x80 : 0x8000000000000000;
 
             uint64_t& rooks = turn == Color::White ? white_rooks : black_rooks;
             rooks &= ~rookFromBB;
             rooks |= rookToBB;
+            mailbox[std::countr_zero(rookFromBB)] = 0;
+            mailbox[std::countr_zero(rookToBB)] = pieceCode(PieceType::Rook, turn);
         }
         else { // Queenside
             uint64_t rookFromBB = turn == Color::White ? 0x8 : 0x800000000000000;
@@ -370,21 +593,25 @@ void Board::undoMove()
             uint64_t& rooks = turn == Color::White ? white_rooks : black_rooks;
             rooks &= ~rookFromBB;
             rooks |= rookToBB;
+            mailbox[std::countr_zero(rookFromBB)] = 0;
+            mailbox[std::countr_zero(rookToBB)] = pieceCode(PieceType::Rook, turn);
         }
     }
 
     // Restore captured piece
     if (state.captured.type != PieceType::None) {
-        if (state.move.type == MoveType::EnPassant) {
+        if (state.move.isEnPassant()) {
             // For en passant, the captured pawn goes to a different square
             int capturedIndex = (turn == Color::White) ? toIndex - 8 : toIndex + 8;
             uint64_t capturedBB = 1ULL << capturedIndex;
             uint64_t& pieceBB = getPieceBB(state.captured.type, state.captured.color);
             pieceBB |= capturedBB;
+            mailbox[capturedIndex] = pieceCode(state.captured.type, state.captured.color);
         }
         else {
             uint64_t& pieceBB = getPieceBB(state.captured.type, state.captured.color);
             pieceBB |= toBB;
+            mailbox[toIndex] = pieceCode(state.captured.type, state.captured.color);
         }
     }
 
@@ -396,38 +623,21 @@ void Board::undoMove()
     enPassantTarget = state.enPassantTarget;
     halfMoveClock = state.halfMoveClock;
     fullMoveNumber = state.fullMoveNumber;
+    hashKey = state.hashKey;
+    pawnKey = state.pawnKey;
+    materialScore = state.material;
+    pstScore = state.pst;
+    phase = state.phase;
 
     // Update aggregate bitboards
     updateAggregateBitboards();
+    assert(mailboxMatches());
+    assert(hashKey == computeZobristHash());
+    assert(evalScoresMatch());
 
     // Remove from history
     moveHistory.pop_back();
-}
-
-uint64_t& Board::getPieceBB(PieceType type, Color color)
-{
-    if (color == Color::White) {
-        switch (type) {
-            case PieceType::Pawn: return white_pawns;
-            case PieceType::Knight: return white_knights;
-            case PieceType::Bishop: return white_bishops;
-            case PieceType::Rook: return white_rooks;
-            case PieceType::Queen: return white_queens;
-            case PieceType::King: return white_kings;
-            default: throw std::runtime_error("Invalid piece type");
-        }
-    }
-    else {
-        switch (type) {
-            case PieceType::Pawn: return black_pawns;
-            case PieceType::Knight: return black_knights;
-            case PieceType::Bishop: return black_bishops;
-            case PieceType::Rook: return black_rooks;
-            case PieceType::Queen: return black_queens;
-            case PieceType::King: return black_kings;
-            default: throw std::runtime_error("Invalid piece type");
-        }
-    }
+    keyHistory.pop_back();
 }
 
 void Board::updateAggregateBitboards()
@@ -439,69 +649,81 @@ void Board::updateAggregateBitboards()
     allPieces = whitePieces | blackPieces;
 }
 
-void Board::loadFEN(std::string_view  fenstr)
+void Board::loadFEN(std::string_view fenstr)
 {
-    fen.load(fenstr);
-        
-    white_pawns = fen.white_pawns;
-    white_rooks = fen.white_rooks;
-    white_knights = fen.white_knights;
-    white_bishops = fen.white_bishops;
-    white_queens = fen.white_queens;
-    white_kings = fen.white_kings;
-    whitePieces = fen.whitePieces;
-
-    black_pawns = fen.black_pawns;
-    black_rooks = fen.black_rooks;
-    black_knights = fen.black_knights;
-    black_bishops = fen.black_bishops;
-    black_queens = fen.black_queens;
-    black_kings = fen.black_kings;
-    blackPieces = fen.blackPieces;
-    allPieces = fen.allPieces;
+    parseFen(fenstr, *this);
+    if (fullMoveNumber <= 0)
+        fullMoveNumber = 1;
+    moveHistory.clear();
+    keyHistory.clear();
+    nullBarrier = 0;
+    assert(mailboxMatches());
+    hashKey = computeZobristHash();
+    pawnKey = computePawnHash();
+    computeEvalScores(materialScore, pstScore, phase);
+}
 
-    whiteKingside = fen.whiteKingside;
-    whiteQueenside = fen.whiteQueenside;
-    blackKingside = fen.blackKingside;
-    blackQueenside = fen.blackQueenside;
+// Every piece of either color attacking the square, found by looking outward
+// from the square with each piece's own attack pattern. Pawns use the opposite
+// color's pattern: a white pawn attacks sq if a black pawn on sq would attack it.
+uint64_t Board::attackersTo(int sq, uint64_t occupied) const
+{
+    return (PAWN_ATTACKS[1][sq] & white_pawns)
+        | (PAWN_ATTACKS[0][sq] & black_pawns)
+        | (KNIGHT_ATTACKS[sq] & (white_knights | black_knights))
+        | (KING_ATTACKS[sq] & (white_kings | black_kings))
+        | (rookAttacks(sq, occupied) & (white_rooks | black_rooks | white_queens | black_queens))
+        | (bishopAttacks(sq, occupied) & (white_bishops | black_bishops | white_queens | black_queens));
+}
 
-    turn = fen.turn;
+bool Board::isSquareAttacked(int sq, Color bySide) const
+{
+    if (bySide == Color::White) {
+        return (PAWN_ATTACKS[1][sq] & white_pawns)
+            || (KNIGHT_ATTACKS[sq] & white_knights)
+            || (KING_ATTACKS[sq] & white_kings)
+            || (bishopAttacks(sq, allPieces) & (white_bishops | white_queens))
+            || (rookAttacks(sq, allPieces) & (white_rooks | white_queens));
+    }
+    return (PAWN_ATTACKS[0][sq] & black_pawns)
+        || (KNIGHT_ATTACKS[sq] & black_knights)
+        || (KING_ATTACKS[sq] & black_kings)
+        || (bishopAttacks(sq, allPieces) & (black_bishops | black_queens))
+        || (rookAttacks(sq, allPieces) & (black_rooks | black_queens));
 }
 
 bool Board::isSquareAttacked(Square sq, Color bySide) const
 {
-    auto theirMoves = generatePseudoLegalMoves(bySide, false);
-    for (const auto& m : theirMoves) {
-        if (m.to.x == sq.x && m.to.y == sq.y)
-            return true;
-    }
-    return false;
+    return isSquareAttacked(sq.y * 8 + sq.x, bySide);
 }
 
 bool Board::isInCheck(Color side) const
 {
-    // Locate the king
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Piece p = get(x, y);
-            if (p.type == PieceType::King && p.color == side)
-                return isSquareAttacked({ x, y }, opposite(side));
-        }
-    }
-    return false;
+    uint64_t king = (side == Color::White) ? white_kings : black_kings;
+    if (!king)
+        return false;
+    return isSquareAttacked(std::countr_zero(king), opposite(side));
 }
 
 bool Board::isCheckmate(Color side)
 {
     if (!isInCheck(side)) return false;
-    auto moves = generateLegalMoves(side);
+    MoveList moves;
+    generateFullyLegalMoves(side, moves);
     return moves.empty();
 }
 
 std::vector<Move> Board::generateLegalMoves(Color side)
 {
-    std::vector<Move> legalMoves;
-    auto pseudoMoves = generatePseudoLegalMoves(side, true);
+    MoveList legalMoves;
+    generateLegalMoves(side, legalMoves);
+    return std::vector<Move>(legalMoves.begin(), legalMoves.end());
+}
+
+void Board::generateLegalMoves(Color side, MoveList& legalMoves)
+{
+    MoveList pseudoMoves;
+    generatePseudoLegalMoves(side, true, pseudoMoves);
 
     for (auto& m : pseudoMoves) {
         makeMove(m);
@@ -509,42 +731,290 @@ std::vector<Move> Board::generateLegalMoves(Color side)
             legalMoves.push_back(m);
         undoMove();
     }
-    return legalMoves;
 }
 
-std::vector<Move> Board::generateKingMoves(Color side, bool includeCastling) const
+uint64_t Board::attackedSquares(Color bySide, uint64_t occupied) const
+{
+    bool white = bySide == Color::White;
+    uint64_t attacks = pawnAttacks(white ? white_pawns : black_pawns, bySide);
+    attacks |= knightAttacks(white ? white_knights : black_knights);
+
+    uint64_t king = white ? white_kings : black_kings;
+    if (king)
+        attacks |= KING_ATTACKS[std::countr_zero(king)];
+
+    uint64_t queens = white ? white_queens : black_queens;
+    for (uint64_t bb = (white ? white_rooks : black_rooks) | queens; bb; bb &= bb - 1)
+        attacks |= rookAttacks(std::countr_zero(bb), occupied);
+    for (uint64_t bb = (white ? white_bishops : black_bishops) | queens; bb; bb &= bb - 1)
+        attacks |= bishopAttacks(std::countr_zero(bb), occupied);
+    return attacks;
+}
+
+void Board::generateFullyLegalMoves(Color side, MoveList& moves) const
 {
-    std::vector<Move> moves;
+    generateLegal(side, GenType::All, moves);
+}
+
+void Board::generateLegalCaptures(Color side, MoveList& moves) const
+{
+    generateLegal(side, GenType::Captures, moves);
+}
+
+void Board::generateLegalQuiets(Color side, MoveList& moves) const
+{
+    generateLegal(side, GenType::Quiets, moves);
+}
+
+void Board::generateLegal(Color side, GenType type, MoveList& moves) const
+{
+    bool white = side == Color::White;
+    Color them = opposite(side);
+
+    uint64_t ownPieces = white ? whitePieces : blackPieces;
+    uint64_t enemyPieces = white ? blackPieces : whitePieces;
+    uint64_t kingBB = white ? white_kings : black_kings;
+    if (kingBB == 0)
+        return;
+    int king = std::countr_zero(kingBB);
+
+    uint64_t enemyPawns = white ? black_pawns : white_pawns;
+    uint64_t enemyKnights = white ? black_knights : white_knights;
+    uint64_t enemyRooks = white ? (black_rooks | black_queens) : (white_rooks | white_queens);
+    uint64_t enemyBishops = white ? (black_bishops | black_queens) : (white_bishops | white_queens);
 
-    auto indexToSquare = [](int index) -> Square
+    auto addMoves = [&](int from, uint64_t targets)
         {
-            return Square{ index % 8, index / 8 };
+            for (; targets; targets &= targets - 1) {
+                int to = std::countr_zero(targets);
+                moves.emplace_back(from, to, (enemyPieces & (1ULL << to)) ? PackedMove::Capture : PackedMove::Quiet);
+            }
         };
 
+    // The king may not step along a checking ray, so its own square is
+    // removed from the occupancy before the enemy attacks are computed.
+    uint64_t danger = attackedSquares(them, allPieces & ~kingBB);
+    // Captures and promotions on one side, everything else on the other
+    uint64_t wanted = type == GenType::Captures ? enemyPieces
+        : type == GenType::Quiets ? ~enemyPieces
+        : ~0ULL;
+    uint64_t promotionRank = white ? RANK_8 : RANK_1;
+    addMoves(king, KING_ATTACKS[king] & ~ownPieces & ~danger & wanted);
+
+    uint64_t checkers = (PAWN_ATTACKS[white ? 0 : 1][king] & enemyPawns)
+        | (KNIGHT_ATTACKS[king] & enemyKnights)
+        | (rookAttacks(king, allPieces) & enemyRooks)
+        | (bishopAttacks(king, allPieces) & enemyBishops);
+
+    // In double check only the king can move
+    if (std::popcount(checkers) > 1)
+        return;
+
+    // Out of check every square is allowed; in check a move must capture the
+    // checker or block between it and the king.
+    uint64_t checkMask = ~0ULL;
+    if (checkers)
+        checkMask = checkers | betweenSquares(king, std::countr_zero(checkers));
+    uint64_t targets = ~ownPieces & checkMask;
+
+    // Pushes onto the last rank count as captures
+    uint64_t pawnTargets = targets;
+    if (type == GenType::Captures)
+        pawnTargets &= enemyPieces | promotionRank;
+    else if (type == GenType::Quiets)
+        pawnTargets &= ~enemyPieces & ~promotionRank;
+    targets &= wanted;
+
+    // A piece is pinned when it is the only piece between the king and an
+    // enemy slider; it may then only move along that line.
+    uint64_t pinned = 0;
+    uint64_t snipers = (rookAttacks(king, enemyPieces) & enemyRooks)
+        | (bishopAttacks(king, enemyPieces) & enemyBishops);
+    for (; snipers; snipers &= snipers - 1) {
+        uint64_t blockers = betweenSquares(king, std::countr_zero(snipers)) & allPieces;
+        if (std::popcount(blockers) == 1)
+            pinned |= blockers & ownPieces;
+    }
+
+    // Pawns: the free ones set-wise, pinned ones one at a time along their line
+    uint64_t pawns = white ? white_pawns : black_pawns;
+    generatePawnMoves(side, pawns & ~pinned, pawnTargets, false, moves);
+    for (uint64_t bb = pawns & pinned; bb; bb &= bb - 1) {
+        int from = std::countr_zero(bb);
+        generatePawnMoves(side, 1ULL << from, pawnTargets & lineThrough(king, from), false, moves);
+    }
+
+    // En passant can uncover a check along the rank of both pawns, so each
+    // capture is verified with the resulting occupancy.
+    if (type != GenType::Quiets && enPassantTarget.x >= 0 && enPassantTarget.y >= 0) {
+        int to = enPassantTarget.y * 8 + enPassantTarget.x;
+        int captured = to + (white ? -8 : 8);
+        for (uint64_t bb = PAWN_ATTACKS[white ? 1 : 0][to] & pawns; bb; bb &= bb - 1) {
+            int from = std::countr_zero(bb);
+            uint64_t occupied = (allPieces ^ (1ULL << from) ^ (1ULL << captured)) | (1ULL << to);
+            uint64_t attackers = attackersTo(king, occupied) & enemyPieces & ~(1ULL << captured);
+            if (!attackers)
+                moves.emplace_back(from, to, PackedMove::EnPassant);
+        }
+    }
+
+    // Pinned knights can never move
+    for (uint64_t bb = (white ? white_knights : black_knights) & ~pinned; bb; bb &= bb - 1) {
+        int from = std::countr_zero(bb);
+        addMoves(from, KNIGHT_ATTACKS[from] & targets);
+    }
+
+    uint64_t queens = white ? white_queens : black_queens;
+    for (uint64_t bb = (white ? white_bishops : black_bishops) | queens; bb; bb &= bb - 1) {
+        int from = std::countr_zero(bb);
+        uint64_t attacks = bishopAttacks(from, allPieces) & targets;
+        if (pinned & (1ULL << from))
+            attacks &= lineThrough(king, from);
+        addMoves(from, attacks);
+    }
+    for (uint64_t bb = (white ? white_rooks : black_rooks) | queens; bb; bb &= bb - 1) {
+        int from = std::countr_zero(bb);
+        uint64_t attacks = rookAttacks(from, allPieces) & targets;
+        if (pinned & (1ULL << from))
+            attacks &= lineThrough(king, from);
+        addMoves(from, attacks);
+    }
+
+    // Castling: not out of check, through or into an attacked square
+    if (checkers || type == GenType::Captures)
+        return;
+    uint64_t rooks = white ? white_rooks : black_rooks;
+    int home = white ? 4 : 60;
+    if (king != home)
+        return;
+    bool kingside = white ? whiteKingside : blackKingside;
+    bool queenside = white ? whiteQueenside : blackQueenside;
+    if (kingside && (rooks & (1ULL << (home + 3)))
+        && !(allPieces & (3ULL << (home + 1))) && !(danger & (3ULL << (home + 1)))) {
+        moves.emplace_back(home, home + 2, PackedMove::KingCastle);
+    }
+    if (queenside && (rooks & (1ULL << (home - 4)))
+        && !(allPieces & (7ULL << (home - 3))) && !(danger & (3ULL << (home - 2)))) {
+        moves.emplace_back(home, home - 2, PackedMove::QueenCastle);
+    }
+}
+
+bool Board::isPseudoLegal(PackedMove move) const
+{
+    // Flags 6 and 7 are never generated
+    if (move.isNull() || move.flags() == 6 || move.flags() == 7)
+        return false;
+
+    bool white = turn == Color::White;
+    uint64_t ownPieces = white ? whitePieces : blackPieces;
+    uint64_t enemyPieces = white ? blackPieces : whitePieces;
+    int from = move.from();
+    int to = move.to();
+    uint64_t toBB = 1ULL << to;
+    Piece piece = pieceOn(from);
+    if (piece.type == PieceType::None || piece.color != turn || (ownPieces & toBB))
+        return false;
+
+    if (move.isCastle()) {
+        int home = white ? 4 : 60;
+        if (piece.type != PieceType::King || from != home)
+            return false;
+        uint64_t rooks = white ? white_rooks : black_rooks;
+        if (move.flags() == PackedMove::KingCastle)
+            return to == home + 2 && (white ? whiteKingside : blackKingside)
+                && (rooks & (1ULL << (home + 3))) && !(allPieces & (3ULL << (home + 1)));
+        return to == home - 2 && (white ? whiteQueenside : blackQueenside)
+            && (rooks & (1ULL << (home - 4))) && !(allPieces & (7ULL << (home - 3)));
+    }
+
+    if (move.isEnPassant()) {
+        return piece.type == PieceType::Pawn && enPassantTarget.x >= 0
+            && to == enPassantTarget.y * 8 + enPassantTarget.x
+            && (PAWN_ATTACKS[white ? 0 : 1][from] & toBB);
+    }
+
+    // The capture flag has to match what stands on the target square
+    if (move.isCapture() != ((enemyPieces & toBB) != 0))
+        return false;
+
+    if (piece.type == PieceType::Pawn) {
+        bool lastRank = (white ? RANK_8 : RANK_1) & toBB;
+        if (lastRank != move.isPromotion())
+            return false;
+        int dir = white ? 8 : -8;
+        if (move.isCapture())
+            return (PAWN_ATTACKS[white ? 0 : 1][from] & toBB) != 0;
+        if (move.flags() == PackedMove::DoublePush)
+            return to == from + 2 * dir && ((white ? RANK_2 : RANK_7) & (1ULL << from))
+                && !(allPieces & ((1ULL << (from + dir)) | toBB));
+        return to == from + dir && !(allPieces & toBB);
+    }
+
+    // Only pawns promote or push two squares
+    if (move.isPromotion() || move.flags() == PackedMove::DoublePush)
+        return false;
+
+    switch (piece.type) {
+        case PieceType::Knight: return (KNIGHT_ATTACKS[from] & toBB) != 0;
+        case PieceType::Bishop: return (bishopAttacks(from, allPieces) & toBB) != 0;
+        case PieceType::Rook: return (rookAttacks(from, allPieces) & toBB) != 0;
+        case PieceType::Queen: return (queenAttacks(from, allPieces) & toBB) != 0;
+        case PieceType::King: return (KING_ATTACKS[from] & toBB) != 0;
+        default: return false;
+    }
+}
+
+// Expects a pseudo-legal move. The move is applied to the occupancy only and
+// the king's square checked for attackers that survive it.
+bool Board::isLegal(PackedMove move) const
+{
+    bool white = turn == Color::White;
+    Color them = opposite(turn);
+    int from = move.from();
+    int to = move.to();
+    int king = std::countr_zero(white ? white_kings : black_kings);
+    uint64_t enemyPieces = white ? blackPieces : whitePieces;
+
+    if (move.isCastle()) {
+        int step = to > from ? 1 : -1;
+        return !isSquareAttacked(from, them) && !isSquareAttacked(from + step, them)
+            && !isSquareAttacked(to, them);
+    }
+
+    uint64_t occupied = (allPieces ^ (1ULL << from)) | (1ULL << to);
+    uint64_t captured = 1ULL << to;
+    if (move.isEnPassant()) {
+        captured = 1ULL << (to + (white ? -8 : 8));
+        occupied ^= captured;
+    }
+    if (from == king)
+        king = to;
+    return !(attackersTo(king, occupied) & enemyPieces & ~captured);
+}
+
+void Board::generateKingMoves(Color side, bool includeCastling, MoveList& moves) const
+{
     uint64_t kingBB = (side == Color::White) ? white_kings : black_kings;
-    if (kingBB == 0) return moves;
+    if (kingBB == 0) return;
 
     uint64_t ownPieces = (side == Color::White) ? whitePieces : blackPieces;
+    uint64_t opponentPieces = (side == Color::White) ? blackPieces : whitePieces;
 
     int kingIndex = std::countr_zero(kingBB);
     uint64_t targets = KING_ATTACKS[kingIndex] & ~ownPieces;
 
     for (uint64_t bb = targets; bb; bb &= bb - 1) {
         int toIndex = std::countr_zero(bb);
-        Square from = indexToSquare(kingIndex);
-        Square to = indexToSquare(toIndex);
-
-        Piece target = get(toIndex % 8, toIndex / 8);
-        if (target.type != PieceType::None && target.color != side) {
-            moves.emplace_back(from, to, MoveType::Capture);
+        if (opponentPieces & (1ULL << toIndex)) {
+            moves.emplace_back(kingIndex, toIndex, PackedMove::Capture);
         }
         else {
-            moves.emplace_back(from, to);
+            moves.emplace_back(kingIndex, toIndex);
         }
     }
 
     if (!includeCastling)
-        return moves;
+        return;
 
 
     // Castling
@@ -552,19 +1022,19 @@ std::vector<Move> Board::generateKingMoves(Color side, bool includeCastling) con
         Piece king = get(4, 0);
         if (whiteKingside && king.type == PieceType::King && king.color == Color::White) {
             Piece rook = get(7, 0);
-            if (rook.type == PieceType::Rook) {
+            if (rook.type == PieceType::Rook && rook.color == Color::White) {
                 if ((allPieces & 0x0000000000000060ULL) == 0 && !isSquareAttacked({ 4, 0 }, Color::Black) &&
                     !isSquareAttacked({ 5, 0 }, Color::Black) && !isSquareAttacked({ 6, 0 }, Color::Black)) {
-                    moves.emplace_back(Square{ 4, 0 }, Square{ 6, 0 }, MoveType::Castle);
+                    moves.emplace_back(4, 6, PackedMove::KingCastle);
                 }
             }
         }
         if (whiteQueenside && king.type == PieceType::King && king.color == Color::White) {
             Piece rook = get(0, 0);
-            if (rook.type == PieceType::Rook) {
+            if (rook.type == PieceType::Rook && rook.color == Color::White) {
                 if ((allPieces & 0x000000000000000EULL) == 0 && !isSquareAttacked({ 4, 0 }, Color::Black) &&
                     !isSquareAttacked({ 3, 0 }, Color::Black) && !isSquareAttacked({ 2, 0 }, Color::Black)) {
-                    moves.emplace_back(Square{ 4, 0 }, Square{ 2, 0 }, MoveType::Castle);
+                    moves.emplace_back(4, 2, PackedMove::QueenCastle);
                 }
             }
         }
@@ -573,208 +1043,134 @@ std::vector<Move> Board::generateKingMoves(Color side, bool includeCastling) con
         Piece king = get(4, 7);
         if (blackKingside && king.type == PieceType::King && king.color == Color::Black) {
             Piece rook = get(7, 7);
-            if (rook.type == PieceType::Rook) {
+            if (rook.type == PieceType::Rook && rook.color == Color::Black) {
                 if ((allPieces & 0x6000000000000000ULL) == 0 && !isSquareAttacked({ 4, 7 }, Color::White) &&
                     !isSquareAttacked({ 5, 7 }, Color::White) && !isSquareAttacked({ 6, 7 }, Color::White)) {
-                    moves.emplace_back(Square{ 4, 7 }, Square{ 6, 7 }, MoveType::Castle);
+                    moves.emplace_back(60, 62, PackedMove::KingCastle);
                 }
             }
         }
         if (blackQueenside && king.type == PieceType::King && king.color == Color::Black) {
             Piece rook = get(0, 7);
-            if (rook.type == PieceType::Rook) {
+            if (rook.type == PieceType::Rook && rook.color == Color::Black) {
                 if ((allPieces & 0x0E00000000000000ULL) == 0 && !isSquareAttacked({ 4, 7 }, Color::White) &&
                     !isSquareAttacked({ 3, 7 }, Color::White) && !isSquareAttacked({ 2, 7 }, Color::White)) {
-                    moves.emplace_back(Square{ 4, 7 }, Square{ 2, 7 }, MoveType::Castle);
+                    moves.emplace_back(60, 58, PackedMove::QueenCastle);
                 }
             }
         }
     }
-
-    return moves; 
 }
 
-uint64_t Board::kingAttacks(uint64_t kingBB) const
+void Board::generateSlidingMoves(Color side, uint64_t pieces, PieceType slider, MoveList& moves) const
 {
-    const uint64_t notAFile = ~FILE_A;
-    const uint64_t notHFile = ~FILE_H;
-
-    uint64_t attacks = 0;
-
-    attacks |= (kingBB << 8);                    // North
-    attacks |= (kingBB >> 8);                    // South
-    attacks |= (kingBB >> 1) & notAFile;         // East (right shift, lower index)
-    attacks |= (kingBB << 1) & notHFile;         // West (left shift, higher index)
-    attacks |= (kingBB << 9) & notAFile;         // NorthEast
-    attacks |= (kingBB << 7) & notHFile;         // NorthWest
-    attacks |= (kingBB >> 7) & notAFile;         // SouthEast
-    attacks |= (kingBB >> 9) & notHFile;         // SouthWest
-
-    return attacks;
-}
-
-std::vector<Move> Board::generateSlidingMoves(Color side, uint64_t pieces, const std::vector<int>& directions) const
-{
-    std::vector<Move> moves;
     uint64_t ownPieces = (side == Color::White) ? whitePieces : blackPieces;
     uint64_t opponentPieces = (side == Color::White) ? blackPieces : whitePieces;
 
-    auto indexToSquare = [](int index) -> Square
-        {
-            return Square{ index % 8, index / 8 };
-        };
-
-    auto onBoard = [](int prev, int curr, int delta)
-        {
-            if (curr < 0 || curr >= 64) return false;
-
-            int px = prev % 8;
-            int py = prev / 8;
-            int cx = curr % 8;
-            int cy = curr / 8;
-
-            int dx = std::abs(cx - px);
-            int dy = std::abs(cy - py);
-
-            switch (delta) {
-                case 1: case -1:       return cy == py && dx > 0;            // Horizontal
-                case 8: case -8:       return cx == px && dy > 0;            // Vertical
-                case 9: case -9:       return dx == dy && dx > 0;            // Diagonal
-                case 7: case -7:       return dx == dy && dx > 0;            // Diagonal
-                default:               return false;
-            }
-        };
-
     for (uint64_t bb = pieces; bb; bb &= bb - 1) {
         int from = std::countr_zero(bb);
-        for (int delta: directions) {
-
-            int to = from + delta;
-
-            int square = from + delta;
-            while (onBoard(from, square, delta)) {
-                uint64_t toBB = 1ULL << square;
-                if (ownPieces & toBB) break;
-                Move m{ indexToSquare(from), indexToSquare(square) };
-                if (opponentPieces & toBB) {
-                    moves.emplace_back(indexToSquare(from), indexToSquare(square), MoveType::Capture);
-                    break;
-                }
-                else {
-                    moves.emplace_back(indexToSquare(from), indexToSquare(square));
-                }
-                if (opponentPieces & toBB) break;
 
-                square += delta;
+        uint64_t targets = 0;
+        switch (slider) {
+            case PieceType::Rook:   targets = rookAttacks(from, allPieces); break;
+            case PieceType::Bishop: targets = bishopAttacks(from, allPieces); break;
+            default:                targets = queenAttacks(from, allPieces); break;
+        }
+        targets &= ~ownPieces;
+
+        for (uint64_t t = targets; t; t &= t - 1) {
+            int to = std::countr_zero(t);
+            if (opponentPieces & (1ULL << to)) {
+                moves.emplace_back(from, to, PackedMove::Capture);
+            }
+            else {
+                moves.emplace_back(from, to);
             }
         }
     }
-
-    return moves;
 }
 
-std::vector<Move> Board::generateRookMoves(Color side) const
+void Board::generateRookMoves(Color side, MoveList& moves) const
 {
     uint64_t rooks = (side == Color::White) ? white_rooks : black_rooks;
-    return generateSlidingMoves(side, rooks, rookDirections);
+    generateSlidingMoves(side, rooks, PieceType::Rook, moves);
 }
 
-std::vector<Move> Board::generateBishopMoves(Color side) const
+void Board::generateBishopMoves(Color side, MoveList& moves) const
 {
     uint64_t bishops = (side == Color::White) ? white_bishops : black_bishops;
-    return generateSlidingMoves(side, bishops, bishopDirections);
+    generateSlidingMoves(side, bishops, PieceType::Bishop, moves);
 }
 
-std::vector<Move> Board::generateQueenMoves(Color side) const
+void Board::generateQueenMoves(Color side, MoveList& moves) const
 {
     uint64_t queens = (side == Color::White) ? white_queens : black_queens;
-    return generateSlidingMoves(side, queens, queenDirections);
+    generateSlidingMoves(side, queens, PieceType::Queen, moves);
 }
 
-std::vector<Move> Board::generateKnightMoves(Color side) const
+void Board::generateKnightMoves(Color side, MoveList& moves) const
 {
     if (side == Color::White)
-        return generateWhiteKnightMoves();
-    return generateBlackKnightMoves();
+        generateWhiteKnightMoves(moves);
+    else
+        generateBlackKnightMoves(moves);
 }
 
-std::vector<Move> Board::generateWhiteKnightMoves() const
+void Board::generateWhiteKnightMoves(MoveList& moves) const
 {
-    std::vector<Move> moves;
-
-    auto indexToSquare = [](int index) -> Square
-        {
-            return Square{ index % 8, index / 8 };
-        };
-
     for (uint64_t knights = white_knights; knights; knights &= knights - 1) {
         int fromIndex = std::countr_zero(knights);
-        uint64_t fromBB = 1ULL << fromIndex;
 
-        uint64_t targets = knightAttacks(fromBB) & ~whitePieces;
+        uint64_t targets = KNIGHT_ATTACKS[fromIndex] & ~whitePieces;
 
         for (uint64_t bb = targets; bb; bb &= bb - 1) {
             int toIndex = std::countr_zero(bb);
 
-            Piece target = get(toIndex % 8, toIndex / 8);
-            if (target.type != PieceType::None && target.color != Color::White) {
-                moves.emplace_back(indexToSquare(fromIndex), indexToSquare(toIndex), MoveType::Capture);
+            if (blackPieces & (1ULL << toIndex)) {
+                moves.emplace_back(fromIndex, toIndex, PackedMove::Capture);
             }
             else {
-                moves.emplace_back(indexToSquare(fromIndex), indexToSquare(toIndex));
+                moves.emplace_back(fromIndex, toIndex);
             }
 
         }
     }
-
-    return moves;
 }
 
-std::vector<Move> Board::generateBlackKnightMoves() const
+void Board::generateBlackKnightMoves(MoveList& moves) const
 {
-    std::vector<Move> moves;
-
-    auto indexToSquare = [](int index) -> Square
-        {
-            return Square{ index % 8, index / 8 };
-        };
-
     for (uint64_t knights = black_knights; knights; knights &= knights - 1) {
         int fromIndex = std::countr_zero(knights);
-        uint64_t fromBB = 1ULL << fromIndex;
 
-        uint64_t targets = knightAttacks(fromBB) & ~blackPieces;
+        uint64_t targets = KNIGHT_ATTACKS[fromIndex] & ~blackPieces;
 
         for (uint64_t bb = targets; bb; bb &= bb - 1) {
             int toIndex = std::countr_zero(bb);
 
-            Piece target = get(toIndex % 8, toIndex / 8);
-            if (target.type != PieceType::None && target.color != Color::Black) {
-                moves.emplace_back(indexToSquare(fromIndex), indexToSquare(toIndex), MoveType::Capture);
+            if (whitePieces & (1ULL << toIndex)) {
+                moves.emplace_back(fromIndex, toIndex, PackedMove::Capture);
             }
             else {
-                moves.emplace_back(indexToSquare(fromIndex), indexToSquare(toIndex));
+                moves.emplace_back(fromIndex, toIndex);
             }
         }
     }
-
-    return moves;
 }
 
-std::vector<Move> Board::generatePawnMoves(Color side) const
+void Board::generatePawnMoves(Color side, MoveList& moves) const
 {
-    auto indexToSquare = [](int index) -> Square
-        {
-            return Square{ index % 8, index / 8 };
-        };
-
-    std::vector<Move> moves;
+    uint64_t pawns = (side == Color::White) ? white_pawns : black_pawns;
+    generatePawnMoves(side, pawns, ~0ULL, true, moves);
+}
 
+// Moves of the given pawns that land on a target square. En passant is
+// not limited by the targets, as the captured pawn is not on the to square.
+void Board::generatePawnMoves(Color side, uint64_t pawns, uint64_t targets, bool enPassant, MoveList& moves) const
+{
     // === Side-dependent constants ===
     int dir = (side == Color::White) ? 8 : -8;
     int dblDir = dir * 2;
 
-    uint64_t pawns = (side == Color::White) ? white_pawns : black_pawns;
     uint64_t opponentPieces = (side == Color::White) ? blackPieces : whitePieces;
     uint64_t startRank = (side == Color::White) ? RANK_2 : RANK_7;
     uint64_t promoRank = (side == Color::White) ? RANK_8 : RANK_1;
@@ -791,6 +1187,9 @@ std::vector<Move> Board::generatePawnMoves(Color side) const
     doublePush = (dir > 0) ? (doublePush << dir) : (doublePush >> -dir);
     doublePush &= empty;
 
+    singlePush &= targets;
+    doublePush &= targets;
+
     // === Captures ===
     uint64_t leftMask = (side == Color::White) ? ~FILE_H : ~FILE_A;
     uint64_t rightMask = (side == Color::White) ? ~FILE_A : ~FILE_H;
@@ -804,9 +1203,12 @@ std::vector<Move> Board::generatePawnMoves(Color side) const
     uint64_t rightCapture = (dir > 0) ? (pawns << rightOffset) : (pawns >> -rightOffset);
     rightCapture &= opponentPieces & rightMask;
 
+    leftCapture &= targets;
+    rightCapture &= targets;
+
     // === En Passant ===
     uint64_t ep = 0;
-    if (enPassantTarget.x >= 0 && enPassantTarget.y >= 0) {
+    if (enPassant && enPassantTarget.x >= 0 && enPassantTarget.y >= 0) {
         ep = 1ULL << (enPassantTarget.y * 8 + enPassantTarget.x);
     }
 
@@ -816,18 +1218,22 @@ std::vector<Move> Board::generatePawnMoves(Color side) const
     uint64_t epRight = (dir > 0) ? (pawns << rightOffset) : (pawns >> -rightOffset);
     epRight &= ep & rightMask;
 
+    auto addPromotions = [&](int from, int to, bool capture)
+        {
+            for (auto pt : { PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight })
+                moves.emplace_back(from, to, PackedMove::promotionFlag(pt, capture));
+        };
+
     // === Single Pushes ===
     for (uint64_t bb = singlePush; bb; bb &= bb - 1) {
         int to = std::countr_zero(bb);
         int from = to - dir;
-        Square fromSq = indexToSquare(from);
-        Square toSq = indexToSquare(to);
 
         if ((1ULL << to) & promoRank) {
-            moves.emplace_back(fromSq, toSq, MoveType::Promotion, PieceType::Queen);
+            addPromotions(from, to, false);
         }
         else {
-            moves.emplace_back(fromSq, toSq, MoveType::Capture);
+            moves.emplace_back(from, to);
         }
     }
 
@@ -835,7 +1241,7 @@ std::vector<Move> Board::generatePawnMoves(Color side) const
     for (uint64_t bb = doublePush; bb; bb &= bb - 1) {
         int to = std::countr_zero(bb);
         int from = to - dblDir;
-        moves.emplace_back(indexToSquare(from), indexToSquare(to));
+        moves.emplace_back(from, to, PackedMove::DoublePush);
     }
 
     // === Captures ===
@@ -844,14 +1250,12 @@ std::vector<Move> Board::generatePawnMoves(Color side) const
             for (; bb; bb &= bb - 1) {
                 int to = std::countr_zero(bb);
                 int from = to - offset;
-                Square fromSq = indexToSquare(from);
-                Square toSq = indexToSquare(to);
 
                 if ((1ULL << to) & promoRank) {
-                    moves.emplace_back(fromSq, toSq, MoveType::Promotion, PieceType::Queen);
+                    addPromotions(from, to, true);
                 }
                 else {
-                    moves.emplace_back(fromSq, toSq);
+                    moves.emplace_back(from, to, PackedMove::Capture);
                 }
             }
         };
@@ -863,39 +1267,23 @@ std::vector<Move> Board::generatePawnMoves(Color side) const
     for (uint64_t bb = epLeft; bb; bb &= bb - 1) {
         int to = std::countr_zero(bb);
         int from = to - leftOffset;
-        moves.emplace_back(indexToSquare(from), indexToSquare(to));
+        moves.emplace_back(from, to, PackedMove::EnPassant);
     }
     for (uint64_t bb = epRight; bb; bb &= bb - 1) {
         int to = std::countr_zero(bb);
         int from = to - rightOffset;
-        moves.emplace_back(indexToSquare(from), indexToSquare(to));
+        moves.emplace_back(from, to, PackedMove::EnPassant);
     }
-    return moves;
 }
 
-std::vector<Move> Board::generatePseudoLegalMoves(Color side, bool includeCastling) const
+void Board::generatePseudoLegalMoves(Color side, bool includeCastling, MoveList& moves) const
 {
-    std::vector<Move> moves;
-
-    auto pawnMoves = generatePawnMoves(side);
-    moves.insert(moves.end(), pawnMoves.begin(), pawnMoves.end());
-
-    auto rookMoves = generateRookMoves(side);
-    moves.insert(moves.end(), rookMoves.begin(), rookMoves.end());
-
-    auto knightMoves = generateKnightMoves(side);
-    moves.insert(moves.end(), knightMoves.begin(), knightMoves.end());
-
-    auto bishopMoves = generateBishopMoves(side);
-    moves.insert(moves.end(), bishopMoves.begin(), bishopMoves.end());
-
-    auto queenMoves = generateQueenMoves(side);
-    moves.insert(moves.end(), queenMoves.begin(), queenMoves.end());
-
-    auto kingMoves = generateKingMoves(side, includeCastling);
-    moves.insert(moves.end(), kingMoves.begin(), kingMoves.end());
-
-    return moves;
+    generatePawnMoves(side, moves);
+    generateRookMoves(side, moves);
+    generateKnightMoves(side, moves);
+    generateBishopMoves(side, moves);
+    generateQueenMoves(side, moves);
+    generateKingMoves(side, includeCastling, moves);
 }
 
 Color Board::getTurn() const
@@ -907,3 +1295,92 @@ Color Board::opposite(Color c) const
 {
     return (c == Color::White) ? Color::Black : Color::White;
 }
+
+int Board::leastValuableAttacker(int sq, Color bySide) const
+{
+    uint64_t attackers = attackersTo(sq, allPieces) & (bySide == Color::White ? whitePieces : blackPieces);
+    for (int t = static_cast<int>(PieceType::Pawn); t <= static_cast<int>(PieceType::King); ++t) {
+        uint64_t bb = attackers & pieces(static_cast<PieceType>(t), bySide);
+        if (bb)
+            return std::countr_zero(bb);
+    }
+    return -1;
+}
+
+// Swap algorithm: each side in turn recaptures with its least valuable
+// attacker, and sliders behind a piece that has just captured join in as
+// x-rays. The gain list is then folded back, each side stopping the
+// exchange as soon as going on would lose.
+int Board::see(PackedMove move) const
+{
+    if (move.isCastle())
+        return 0;
+
+    auto value = [](PieceType type) { return PIECE_SCORE[static_cast<int>(type)].mg; };
+
+    int from = move.from();
+    int to = move.to();
+    Piece mover = pieceOn(from);
+    uint64_t occupied = allPieces ^ (1ULL << from);
+
+    PieceType captured = pieceOn(to).type;
+    if (move.isEnPassant()) {
+        captured = PieceType::Pawn;
+        occupied ^= 1ULL << (to + (mover.color == Color::White ? -8 : 8));
+    }
+
+    int gain[32];
+    int depth = 0;
+    gain[0] = value(captured);
+    PieceType onSquare = mover.type;
+    if (move.isPromotion()) {
+        gain[0] += value(move.promotionType()) - value(PieceType::Pawn);
+        onSquare = move.promotionType();
+    }
+
+    uint64_t diagonal = white_bishops | black_bishops | white_queens | black_queens;
+    uint64_t straight = white_rooks | black_rooks | white_queens | black_queens;
+    uint64_t attackers = attackersTo(to, occupied) & occupied;
+    Color side = opposite(mover.color);
+
+    for (;;) {
+        uint64_t own = attackers & (side == Color::White ? whitePieces : blackPieces);
+        if (!own)
+            break;
+
+        PieceType type = PieceType::Pawn;
+        uint64_t bb = 0;
+        for (int t = static_cast<int>(PieceType::Pawn); t <= static_cast<int>(PieceType::King); ++t) {
+            type = static_cast<PieceType>(t);
+            bb = own & pieces(type, side);
+            if (bb)
+                break;
+        }
+
+        // Whatever took, sliders lined up behind it now reach the square
+        uint64_t cleared = occupied ^ (bb & (0 - bb));
+        uint64_t revealed = (attackers | (bishopAttacks(to, cleared) & diagonal)
+            | (rookAttacks(to, cleared) & straight)) & cleared;
+
+        // The king may only take when nothing can take it back
+        uint64_t theirs = revealed & (side == Color::White ? blackPieces : whitePieces);
+        if (type == PieceType::King && theirs)
+            break;
+
+        ++depth;
+        gain[depth] = value(onSquare) - gain[depth - 1];
+        occupied = cleared;
+        attackers = revealed;
+
+        onSquare = type;
+        side = opposite(side);
+        if (depth == 31)
+            break;
+    }
+
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        --depth;
+    }
+    return gain[0];
+}
@@ -9,53 +9,22 @@
 
 #include "square.h"
 #include "move.h"
+#include "movelist.h"
+#include "psqt.h"
+#include "position.h"
 
 
-class Board  {
+// A Position plus the history needed to take moves back
+class Board : public Position {
 
 public:
-    bool operator== (Board other)
-    {
-        return
-            castlingRights == other.castlingRights &&
-            halfMoveClock == other.halfMoveClock &&
-            fullMoveNumber == other.fullMoveNumber &&
-            whiteKingside == other.whiteKingside &&
-            whiteQueenside == other.whiteQueenside &&
-            blackKingside == other.blackKingside &&
-            blackQueenside == other.blackQueenside &&
-
-            white_pawns == other.white_pawns &&
-            white_knights == other.white_knights &&
-            white_bishops == other.white_bishops &&
-            white_rooks == other.white_rooks &&
-            white_queens == other.white_queens &&
-            white_kings == other.white_kings &&
-
-            black_pawns == other.black_pawns &&
-            black_knights == other.black_knights &&
-            black_bishops == other.black_bishops &&
-            black_rooks == other.black_rooks &&
-            black_queens == other.black_queens &&
-            black_kings == other.black_kings &&
-
-            whitePieces == other.whitePieces &&
-            blackPieces == other.blackPieces &&
-            allPieces == other.allPieces;
-    }
-
-    // this is second one '!='
-    bool operator!= (Board other)
-    {
-        return !(*this == other);
-    }
     std::string toString() const;
 
     
 private:
 
     struct BoardState {
-        Move move;
+        PackedMove move;
         Piece captured;
         bool whiteKingside;
         bool whiteQueenside;
@@ -64,76 +33,124 @@ private:
         Square enPassantTarget;
         int halfMoveClock;
         int fullMoveNumber;
+        uint64_t hashKey;
+        uint64_t pawnKey;
+        int nullBarrier;   // restored when a null move is taken back
+        std::array<Score, 2> material;
+        std::array<Score, 2> pst;
+        int phase;
     };
 
-    std::vector<Move> generatePawnMoves(Color side) const;
-    std::vector<Move> generateKnightMoves(Color side) const;
-    std::vector<Move> generateWhiteKnightMoves() const;
-    std::vector<Move> generateBlackKnightMoves() const;
-    std::vector<Move> generateRookMoves(Color side) const;
-    std::vector<Move> generateBishopMoves(Color side) const;
-    std::vector<Move> generateQueenMoves(Color side) const;
-    std::vector<Move> generateKingMoves(Color side, bool includeCastling) const;
-
-    std::vector<Move> generateSlidingMoves(Color side, uint64_t pieces, const std::vector<int>& directions) const;
+    void generatePawnMoves(Color side, MoveList& moves) const;
+    void generatePawnMoves(Color side, uint64_t pawns, uint64_t targets, bool enPassant, MoveList& moves) const;
+    void generateKnightMoves(Color side, MoveList& moves) const;
+    void generateWhiteKnightMoves(MoveList& moves) const;
+    void generateBlackKnightMoves(MoveList& moves) const;
+    void generateRookMoves(Color side, MoveList& moves) const;
+    void generateBishopMoves(Color side, MoveList& moves) const;
+    void generateQueenMoves(Color side, MoveList& moves) const;
+    void generateKingMoves(Color side, bool includeCastling, MoveList& moves) const;
+
+    void generateSlidingMoves(Color side, uint64_t pieces, PieceType slider, MoveList& moves) const;
     void updateAggregateBitboards();
-    uint64_t& getPieceBB(PieceType type, Color color);
 
 
 public:
     Board();
-    Board(std::string fen);
+    Board(std::string_view fen);
+    explicit Board(const Position& position);
     void reset();
 
+    const Position& position() const { return *this; }
+    // Replaces the position and forgets the moves that led to the old one
+    void setPosition(const Position& position);
+    // As above, but keeps the keys of the game that led to the position, so
+    // repetitions of it are still found
+    void setPosition(const Position& position, const std::vector<uint64_t>& keys);
+    // Keys of the positions before each move made, oldest first
+    const std::vector<uint64_t>& keys() const { return keyHistory; }
+
     Color getTurn() const;
+    void setTurn(Color side);
     const Piece get(int x, int y) const;
     void makeMove(const Move& m);
+    void makeMove(PackedMove m);
+    // Passes the turn without moving, for null-move pruning. Must not be
+    // played in check; undoMove takes it back like any other move.
+    void makeNullMove();
     void undoMove();
+    // Room for this many more moves without reallocating the undo history
+    void reserveHistory(size_t moves)
+    {
+        moveHistory.reserve(moveHistory.size() + moves);
+        keyHistory.reserve(keyHistory.size() + moves);
+    }
+    // The position occurred before, with nothing irreversible played since
+    bool isRepetition() const;
+    // Drawn by repetition or by the fifty-move rule, unless the move that
+    // reached the hundredth reversible ply gave mate
+    bool isDraw() const;
     void loadFEN(std::string_view);
     bool isSquareAttacked(Square sq, Color bySide) const;
+    bool isSquareAttacked(int sq, Color bySide) const;
+    uint64_t attackersTo(int sq, uint64_t occupied) const;
     bool isInCheck(Color side) const;
     bool isCheckmate(Color side);
     std::vector<Move> generateLegalMoves(Color side);
-
-    Color turn;
-    Square enPassantTarget;
-    uint8_t castlingRights;
-    int halfMoveClock = 0;
-    int fullMoveNumber = 0;
-    bool whiteKingside = false;
-    bool whiteQueenside = false;
-    bool blackKingside = false;
-    bool blackQueenside = false;
-
-    uint64_t white_pawns;
-    uint64_t white_knights;
-    uint64_t white_bishops;
-    uint64_t white_rooks;
-    uint64_t white_queens;
-    uint64_t white_kings;
-
-    uint64_t black_pawns;
-    uint64_t black_knights;
-    uint64_t black_bishops;
-    uint64_t black_rooks;
-    uint64_t black_queens;
-    uint64_t black_kings;
-
-    uint64_t allPieces;            // all pieces on the board
-    uint64_t whitePieces;
-    uint64_t blackPieces;
-
-    std::array<uint64_t, 6> whitePieceType; // [Pawn, Knight, Bishop, Rook, Queen, King]
-    std::array<uint64_t, 6> blackPieceType; // same
+    void generateLegalMoves(Color side, MoveList& moves);
+    // Emits only legal moves, from checkers and pins computed once up front
+    // instead of trying each pseudo-legal move on the board.
+    void generateFullyLegalMoves(Color side, MoveList& moves) const;
+    // The legal captures and promotions only, for the quiescence search
+    void generateLegalCaptures(Color side, MoveList& moves) const;
+    // Everything generateLegalCaptures leaves out
+    void generateLegalQuiets(Color side, MoveList& moves) const;
+    // Cheap checks for a move from elsewhere, such as the transposition
+    // table: whether it could be played here, and if so whether it leaves
+    // the king safe. Together they agree with generateFullyLegalMoves.
+    bool isPseudoLegal(PackedMove move) const;
+    bool isLegal(PackedMove move) const;
+    // Every square attacked by a side, for the given occupancy
+    uint64_t attackedSquares(Color bySide, uint64_t occupied) const;
+    // Static exchange evaluation: the material the moving side comes out
+    // with once both sides have made every capture on the target square that
+    // pays, least valuable attacker first. Pins are not considered.
+    int see(PackedMove move) const;
+    // The least valuable piece of a side attacking a square, -1 if none
+    int leastValuableAttacker(int sq, Color bySide) const;
 
     Color opposite(Color c) const;
 
-    uint64_t zobristHash() const;
+    // Full recomputation from the pieces, for loading and checking
+    uint64_t computeZobristHash() const;
+    uint64_t computePawnHash() const;
+    // Full recomputation of the sums from the pieces
+    void computeEvalScores(std::array<Score, 2>& material, std::array<Score, 2>& pst, int& phase) const;
+
+    // Cheap estimate of the key after a move, for prefetching. Castling,
+    // promotion and the new en passant square are not accounted for.
+    uint64_t keyAfter(PackedMove move) const;
 
 private:
     std::vector<BoardState> moveHistory;
+    // hashKey before each move, in step with moveHistory but compact to scan
+    std::vector<uint64_t> keyHistory;
+    // Keys before this index come before the last null move
+    int nullBarrier = 0;
+
+    void addPieceScore(PieceType type, Color color, int sq);
+    void removePieceScore(PieceType type, Color color, int sq);
+    bool evalScoresMatch() const;
+
+    Piece pieceFromBitboards(int sq) const;
+    bool mailboxMatches() const;
+
+    uint64_t pieceHash(PieceType type, Color color, int sq) const;
+    uint64_t castlingHash() const;
+    uint64_t enPassantHash() const;
 
     bool isInside(int x, int y) const;
-    std::vector<Move> generatePseudoLegalMoves(Color side, bool includeCastling) const;
-    uint64_t kingAttacks(uint64_t kingBB) const;
+    void generatePseudoLegalMoves(Color side, bool includeCastling, MoveList& moves) const;
+    enum class GenType { All, Captures, Quiets };
+    void generateLegal(Color side, GenType type, MoveList& moves) const;
 };
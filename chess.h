@@ -3,4 +3,3 @@
 #include "fen.h"
 #include "board.h"
 
-extern Fen fen;
@@ -1,68 +1,484 @@
 // engine.cpp
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
 #include <limits>
 #include <iostream>
 #include <assert.h>
-#include <future>
 #include <vector>
-#include <unordered_map>
 
+#include "attacks.h"
+#include "bitboard.h"
 #include "engine.h"
+#include "movepicker.h"
 #include "chess.h"
+#include "tt.h"
 #include "zobrist.h"
 
-struct TTEntry {
-    int depth;
-    int64_t value;
-    // Optionally: you can add a flag for exact/alpha/beta, and best move
-};
-
-Fen fen;
 Zobrist zobrist;
-thread_local std::unordered_map<uint64_t, TTEntry> transTable;
+
+// Mate scores are stored relative to the node rather than the root, so the
+// same entry is correct wherever the position is reached in the tree.
+static int32_t scoreToTT(int64_t score, int ply)
+{
+    if (score > Engine::MATE_BOUND) return static_cast<int32_t>(score + ply);
+    if (score < -Engine::MATE_BOUND) return static_cast<int32_t>(score - ply);
+    return static_cast<int32_t>(score);
+}
+
+static int64_t scoreFromTT(int32_t score, int ply)
+{
+    if (score > Engine::MATE_BOUND) return score - ply;
+    if (score < -Engine::MATE_BOUND) return score + ply;
+    return score;
+}
+
+// Lazy SMP: helpers skip some depths so that threads spread over several
+// iterations at once instead of all searching the same tree.
+static const int skipSize[] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int skipPhase[] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+Engine::Engine()
+{
+    setParams(SearchParams{});
+    setThreads(1);
+}
+
+Engine::~Engine()
+{
+    stop();
+    waitForSearch();
+    stopHelpers();
+}
+
+void Engine::setThreads(int count)
+{
+    stopHelpers();
+
+    count = std::max(count, 1);
+    workers.clear();
+    for (int i = 0; i < count; ++i) {
+        workers.push_back(std::make_unique<SearchThread>());
+        workers.back()->id = i;
+        workers.back()->evalCache.resize(evalCacheKb);
+    }
+
+    quit = false;
+    for (int i = 1; i < count; ++i)
+        helpers.emplace_back(&Engine::helperLoop, this, std::ref(*workers[i]));
+}
+
+void Engine::stopHelpers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& helper : helpers)
+        helper.join();
+    helpers.clear();
+}
+
+void Engine::helperLoop(SearchThread& thread)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return quit || searchId != seen; });
+            if (quit)
+                return;
+            seen = searchId;
+        }
+
+        // Helpers run until the main thread is done with them
+        iterativeDeepening(thread, MAX_DEPTH);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0)
+            idle.notify_all();
+    }
+}
 
 Move Engine::findBestMove(Board& board, int depth, std::vector<Move>& moves)
 {
-    moves = board.generateLegalMoves(board.getTurn());
-    std::vector<std::future<int64_t>> futures;
-    std::vector<Move> moveList = moves;
+    std::vector<PackedMove> pv;
+    return findBestMove(board, depth, moves, pv);
+}
+
+Move Engine::findBestMove(Board& board, int depth, std::vector<Move>& moves, std::vector<PackedMove>& pv)
+{
+    MoveList ordered;
+    board.generateFullyLegalMoves(board.getTurn(), ordered);
+    orderMoves(board, ordered);
+    moves.clear();
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        moves.emplace_back(ordered[i]);
+        moves.back().score = ordered.score(i);
+    }
+
+    SearchLimits depthLimit;
+    depthLimit.depth = std::max(depth, 1);
+    auto result = search(board, depthLimit);
+    pv = std::move(result.pv);
+    return result.bestMove;
+}
+
+SearchResult Engine::search(Board& board, const SearchLimits& searchLimits)
+{
+    stopped = false;
+    pondering = searchLimits.ponder;
+    return runSearch(board, searchLimits);
+}
+
+void Engine::startSearch(const Board& board, const SearchLimits& searchLimits, std::function<void(const SearchResult&)> done)
+{
+    waitForSearch();
+    searchBoard = board;
+
+    // Reset here rather than on the new thread, so a stop or ponderhit sent
+    // straight after this returns is never lost
+    stopped = false;
+    pondering = searchLimits.ponder;
+    searcher = std::thread([this, searchLimits, done = std::move(done)]()
+        {
+            done(runSearch(searchBoard, searchLimits));
+        });
+}
+
+void Engine::waitForSearch()
+{
+    if (searcher.joinable())
+        searcher.join();
+}
+
+SearchResult Engine::runSearch(const Board& board, const SearchLimits& searchLimits)
+{
+    SearchResult result;
+
+    limits = searchLimits;
+    MoveList rootMoves;
+    board.generateFullyLegalMoves(board.getTurn(), rootMoves);
+    if (rootMoves.empty()) {
+        // Mate or stalemate: nothing to search, but the reply still waits
+        waitForStop();
+        return result;
+    }
+
+    timer.start(limits, board.getTurn());
+    transTable.newSearch();
+    for (auto& worker : workers) {
+        worker->board.setPosition(board, board.keys());
+        worker->board.reserveHistory(MAX_PLY);
+        worker->stack.fill(SearchStack{});
+        worker->history.age();
+        worker->pawns.resetCounters();
+        worker->evalCache.resetCounters();
+        worker->nullMinPly = 0;
+        worker->nodes = 0;
+        worker->completedDepth = 0;
+        worker->bestMove = PackedMove{};
+        worker->bestScore = 0;
+        worker->bestLine.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = static_cast<int>(helpers.size());
+        ++searchId;
+    }
+    wake.notify_all();
+
+    iterativeDeepening(*workers[0], limits.depth > 0 ? std::min(limits.depth, MAX_DEPTH) : MAX_DEPTH);
+    waitForStop();
+
+    stopped = true;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&]() { return running == 0; });
+    }
+
+    // Take the deepest completed iteration, the main thread on a tie
+    const SearchThread* best = workers[0].get();
+    for (auto& worker : workers) {
+        if (worker->completedDepth > best->completedDepth && !worker->bestMove.isNull())
+            best = worker.get();
+    }
+
+    // Stopped before any iteration finished: any legal move beats none
+    result = currentResult(*best);
+    if (best->bestMove.isNull()) {
+        result.bestMove = Move(rootMoves[0]);
+        result.pv.assign(1, rootMoves[0]);
+    }
+    return result;
+}
 
-    orderMoves(board, moves);
+// An infinite or pondering search reports only once it is told to
+void Engine::waitForStop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stopSignal.wait(lock, [&]()
+        {
+            return stopped.load() || (!limits.infinite && !pondering.load());
+        });
+}
 
-    for (auto& move : moveList) {
-        futures.push_back(std::async(std::launch::async, [&, move]()
-            {
-                Board next = board;
-                next.makeMove(move);
-                return minimax(next, depth - 1, std::numeric_limits<int>::min(),
-                    std::numeric_limits<int>::max(), board.getTurn() == Color::Black);
-            }));
+void Engine::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
     }
+    stopSignal.notify_all();
+}
+
+void Engine::ponderhit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pondering = false;
+    }
+    stopSignal.notify_all();
+}
+
+SearchResult Engine::currentResult(const SearchThread& thread)
+{
+    SearchResult result;
+    result.bestMove = Move(thread.bestMove);
+    result.bestMove.score = thread.bestScore;
+    result.score = thread.bestScore;
+    result.depth = thread.completedDepth;
+    result.nodes = totalNodes();
+    result.time = timer.elapsed();
+    result.pv = thread.bestLine;
+    return result;
+}
+
+// The child's line with the move leading to it in front
+static void updatePv(SearchThread& thread, int ply, PackedMove move)
+{
+    auto& line = thread.pv[ply];
+    int childLength = thread.pvLength[ply + 1];
+    line[0] = move;
+    std::copy_n(thread.pv[ply + 1].begin(), childLength, line.begin() + 1);
+    thread.pvLength[ply] = childLength + 1;
+}
+
+uint64_t Engine::pawnProbes() const
+{
+    uint64_t probes = 0;
+    for (auto& worker : workers)
+        probes += worker->pawns.probes();
+    return probes;
+}
+
+uint64_t Engine::pawnHits() const
+{
+    uint64_t hits = 0;
+    for (auto& worker : workers)
+        hits += worker->pawns.hits();
+    return hits;
+}
+
+void Engine::setHashSize(size_t megabytes)
+{
+    transTable.resize(megabytes);
+}
+
+void Engine::clearHash()
+{
+    transTable.clear();
+}
+
+void Engine::setEvalCacheSize(size_t kilobytes)
+{
+    evalCacheKb = kilobytes;
+    for (auto& worker : workers)
+        worker->evalCache.resize(kilobytes);
+}
+
+uint64_t Engine::evalCacheProbes() const
+{
+    uint64_t probes = 0;
+    for (auto& worker : workers)
+        probes += worker->evalCache.probes();
+    return probes;
+}
+
+uint64_t Engine::evalCacheHits() const
+{
+    uint64_t hits = 0;
+    for (auto& worker : workers)
+        hits += worker->evalCache.hits();
+    return hits;
+}
+
+uint64_t Engine::totalNodes() const
+{
+    uint64_t nodes = 0;
+    for (auto& worker : workers)
+        nodes += worker->nodes.load(std::memory_order_relaxed);
+    return nodes;
+}
+
+// Polled by the main thread during the search
+void Engine::checkLimits()
+{
+    if ((!pondering.load(std::memory_order_relaxed) && timer.hardExpired()) || (limits.nodes && totalNodes() >= limits.nodes))
+        stopped = true;
+}
+
+void Engine::iterativeDeepening(SearchThread& thread, int maxDepth)
+{
+    int stability = 0;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        if (thread.id > 0) {
+            int i = (thread.id - 1) % 20;
+            if (((depth + skipPhase[i]) / skipSize[i]) % 2)
+                continue;
+        }
+
+        // Aspiration: search a narrow window around the last score first and
+        // widen it on the side that failed. A fail low's move is not trusted.
+        int64_t delta = ASPIRATION_WINDOW;
+        int64_t alpha = -INFINITE_SCORE;
+        int64_t beta = INFINITE_SCORE;
+        if (depth >= ASPIRATION_MIN_DEPTH && thread.completedDepth > 0 && std::abs(thread.bestScore) < MATE_BOUND) {
+            alpha = thread.bestScore - delta;
+            beta = thread.bestScore + delta;
+        }
 
-    auto bestValue = std::numeric_limits<int64_t>::min();
-    int bestIndex = 0;
-    for (size_t i = 0; i < futures.size(); ++i) {
-        try {
-            auto eval = futures[i].get();
-            moveList[i].score = eval;
-            if (eval > bestValue) {
-                bestValue = eval;
-                bestIndex = static_cast<int>(i);
+        PackedMove bestMove{};
+        int64_t score = 0;
+        while (true) {
+            PackedMove move{};
+            score = searchRoot(thread, depth, alpha, beta, move);
+            if (stopped.load(std::memory_order_relaxed))
+                break;
+
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -INFINITE_SCORE);
+            }
+            else if (score >= beta) {
+                beta = std::min(score + delta, INFINITE_SCORE);
+            }
+            else {
+                bestMove = move;
+                break;
             }
+            delta += delta / 2;
         }
-        catch (const std::exception& ex) {
-            std::cerr << "Exception in async move " << i << ": " << ex.what() << std::endl;
-            moveList[i].score = std::numeric_limits<int>::min(); // or another sentinel value
+        if (stopped.load(std::memory_order_relaxed))
+            break;
+
+        stability = (bestMove == thread.bestMove) ? stability + 1 : 0;
+        thread.completedDepth = depth;
+        thread.bestMove = bestMove;
+        thread.bestScore = score;
+        if (thread.pvLength[0] > 0 && thread.pv[0][0] == bestMove)
+            thread.bestLine.assign(thread.pv[0].begin(), thread.pv[0].begin() + thread.pvLength[0]);
+        else
+            thread.bestLine.assign(1, bestMove);
+
+        // Only the main thread decides when the search is over. A found mate
+        // will not get any shorter by searching deeper.
+        if (thread.id == 0) {
+            if (infoHandler)
+                infoHandler(currentResult(thread));
+            if (pondering.load(std::memory_order_relaxed))
+                continue;
+            if (timer.softExpired(stability))
+                break;
+            if (!limits.infinite && std::abs(score) > MATE_BOUND && depth >= MATE_SCORE - std::abs(score))
+                break;
         }
-        catch (...) {
-            std::cerr << "Unknown exception in async move " << i << std::endl;
-            moveList[i].score = std::numeric_limits<int>::min();
+    }
+}
+
+int64_t Engine::searchRoot(SearchThread& thread, int depth, int64_t alpha, int64_t beta, PackedMove& bestMove)
+{
+    Board& board = thread.board;
+    uint64_t hash = board.zobristHash();
+
+    TTEntry entry;
+    PackedMove ttMove = transTable.probe(hash, entry) ? entry.move : PackedMove{};
+
+    MoveList moves;
+    board.generateFullyLegalMoves(board.getTurn(), moves);
+    orderMoves(board, moves, ttMove);
+
+    // Principal variation search: the first move gets the full window, the
+    // rest only have to be shown worse with a null window, and are searched
+    // again with the full one if they are not
+    int64_t alphaOrig = alpha;
+    int64_t bestValue = -INFINITE_SCORE;
+    thread.stack[0].ttMove = ttMove;
+    thread.pvLength[0] = 0;
+    int moveCount = 0;
+    for (const auto& move : moves) {
+        ++moveCount;
+        thread.stack[0].move = move;
+        board.makeMove(move);
+        int64_t eval;
+        if (moveCount == 1) {
+            eval = -negamax(thread, depth - 1, 1, -beta, -alpha);
+        }
+        else {
+            eval = -negamax(thread, depth - 1, 1, -alpha - 1, -alpha);
+            if (eval > alpha && eval < beta)
+                eval = -negamax(thread, depth - 1, 1, -beta, -alpha);
+        }
+        board.undoMove();
+        if (stopped.load(std::memory_order_relaxed))
+            return bestValue;
+
+        if (eval > bestValue) {
+            bestValue = eval;
+            bestMove = move;
         }
+        if (eval > alpha) {
+            alpha = eval;
+            updatePv(thread, 0, move);
+        }
+        if (alpha >= beta)
+            break;
     }
-    if (futures.size() == 0) {
-        return Move();
+
+    TTFlag flag = bestValue <= alphaOrig ? TTFlag::Upper
+        : bestValue >= beta ? TTFlag::Lower
+        : TTFlag::Exact;
+    transTable.store(hash, flag == TTFlag::Upper ? PackedMove{} : bestMove, scoreToTT(bestValue, 0), depth, flag);
+    return bestValue;
+}
+
+void Engine::setParams(const SearchParams& params)
+{
+    searchParams = params;
+    for (int depth = 1; depth < 64; ++depth) {
+        for (int moves = 1; moves < 64; ++moves) {
+            double r = (params.lmrBase + std::log(depth) * std::log(moves) * 100 / std::max(params.lmrDivisor, 1)) / 100;
+            reductions[depth][moves] = static_cast<uint8_t>(std::clamp(r, 0.0, 63.0));
+        }
     }
-    return moveList[bestIndex];
+}
+
+int Engine::reduction(int depth, int moveCount) const
+{
+    return reductions[std::min(depth, 63)][std::min(moveCount, 63)];
+}
+
+// Pieces other than pawns and the king. Without them zugzwang is common and
+// passing the move is no longer a safe lower bound.
+static int64_t pieceMaterial(const Board& board, Color side)
+{
+    return std::popcount(board.pieces(PieceType::Knight, side)) * PIECE_SCORE[static_cast<int>(PieceType::Knight)].mg
+        + std::popcount(board.pieces(PieceType::Bishop, side)) * PIECE_SCORE[static_cast<int>(PieceType::Bishop)].mg
+        + std::popcount(board.pieces(PieceType::Rook, side)) * PIECE_SCORE[static_cast<int>(PieceType::Rook)].mg
+        + std::popcount(board.pieces(PieceType::Queen, side)) * PIECE_SCORE[static_cast<int>(PieceType::Queen)].mg;
 }
 
 // In engine.cpp or a suitable place
@@ -79,186 +495,411 @@ int64_t pieceValue(PieceType pt)
     }
 }
 
-void Engine::orderMoves(Board& board, std::vector<Move>& moves)
+void Engine::orderMoves(Board& board, MoveList& moves, PackedMove ttMove)
 {
-    for (auto& move : moves) {
-        move.score = 0;
-
-        // Score captures higher
-        Piece captured = board.get(move.to.x, move.to.y);
+    for (size_t i = 0; i < moves.size(); ++i) {
+        auto move = moves[i];
+        int64_t score = 0;
+
+        // The stored best move is tried first, then captures that do not
+        // lose material by MVV-LVA, quiet moves, and losing captures last
+        if (move == ttMove) {
+            moves.score(i) = std::numeric_limits<int32_t>::max();
+            continue;
+        }
+        Piece captured = board.pieceOn(move.to());
         if (captured.type != PieceType::None) {
-            move.score = pieceValue(captured.type) - pieceValue(board.get(move.from.x, move.from.y).type) / 10;
+            int see = board.see(move);
+            score = see >= 0
+                ? GOOD_CAPTURE + pieceValue(captured.type) - pieceValue(board.pieceOn(move.from()).type) / 10
+                : see;
         }
-        else if (move.type == MoveType::Promotion) {
-            move.score += 800 + pieceValue(move.promotionType);
+        else if (move.isPromotion()) {
+            score = GOOD_CAPTURE + 800 + pieceValue(move.promotionType());
         }
+        moves.score(i) = static_cast<int32_t>(score);
     }
-    std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b)
-        {
-            return a.score > b.score;
-        });
+    moves.sortByScore();
 }
 
-// Example: White pawn PST (flip for black)
-static const int pawnPST[8][8] = {
-    { 0, 0, 0, 0, 0, 0, 0, 0 },
-    { 5, 10, 10, -20, -20, 10, 10, 5 },
-    { 5, -5, -10, 0, 0, -10, -5, 5 },
-    { 0, 0, 0, 20, 20, 0, 0, 0 },
-    { 5, 5, 10, 25, 25, 10, 5, 5 },
-    { 10, 10, 20, 30, 30, 20, 10, 10 },
-    { 50, 50, 50, 50, 50, 50, 50, 50 },
-    { 0, 0, 0, 0, 0, 0, 0, 0 }
+// Terms for one side, from that side's point of view. Attack sets are
+// collected on the way so the caller can look for hanging pieces.
+struct SideEval {
+    int64_t score = 0;
+    int mobility = 0;
+    uint64_t attacks = 0;
 };
 
+static SideEval evaluateSide(const Board& board, const PawnEntry& pawnEntry, Color side)
+{
+    static const uint64_t centerSquares = (1ULL << 27) | (1ULL << 28) | (1ULL << 35) | (1ULL << 36);
+    const int centerBonus = 50; // Tune as desired
 
+    bool white = side == Color::White;
+    uint64_t own = white ? board.whitePieces : board.blackPieces;
+    uint64_t enemy = white ? board.blackPieces : board.whitePieces;
+    uint64_t occupied = board.allPieces;
+
+    uint64_t pawns = white ? board.white_pawns : board.black_pawns;
+    uint64_t knights = white ? board.white_knights : board.black_knights;
+    uint64_t bishops = white ? board.white_bishops : board.black_bishops;
+    uint64_t rooks = white ? board.white_rooks : board.black_rooks;
+    uint64_t queens = white ? board.white_queens : board.black_queens;
+    uint64_t kings = white ? board.white_kings : board.black_kings;
+
+    int c = white ? 0 : 1;
+    SideEval eval;
+
+    // King safety: bonus while castling is still possible
+    if (white ? (board.whiteKingside || board.whiteQueenside) : (board.blackKingside || board.blackQueenside))
+        eval.score += 300;
+
+    // Bishop pair
+    if (std::popcount(bishops) >= 2)
+        eval.score += 300;
+
+    // Center control for pawns and knights
+    eval.score += std::popcount((pawns | knights) & centerSquares) * centerBonus;
+
+    // Knight outposts: on the far half, backed by a pawn and out of reach
+    // of every enemy pawn
+    uint64_t farHalf = white ? 0x00ffffff00000000ULL : 0x00000000ffffff00ULL;
+    eval.score += 25 * std::popcount(knights & farHalf & pawnEntry.attacks[c] & ~pawnEntry.attackSpan[c ^ 1]);
+
+    // Mobility: squares each piece can move to, pushes and captures for pawns
+    uint64_t pawnHits = pawnEntry.attacks[c];
+    uint64_t singlePush = (white ? pawns << 8 : pawns >> 8) & ~occupied;
+    uint64_t doublePush = (white ? (singlePush & (RANK_2 << 8)) << 8 : (singlePush & (RANK_7 >> 8)) >> 8) & ~occupied;
+    eval.attacks = pawnHits;
+    eval.mobility = std::popcount(singlePush) + std::popcount(doublePush) + std::popcount(pawnHits & enemy);
+
+    auto addAttacks = [&](uint64_t attacks)
+        {
+            eval.attacks |= attacks;
+            eval.mobility += std::popcount(attacks & ~own);
+        };
+    for (uint64_t bb = knights; bb; bb &= bb - 1)
+        addAttacks(KNIGHT_ATTACKS[std::countr_zero(bb)]);
+    for (uint64_t bb = bishops; bb; bb &= bb - 1)
+        addAttacks(bishopAttacks(std::countr_zero(bb), occupied));
+    for (uint64_t bb = rooks; bb; bb &= bb - 1)
+        addAttacks(rookAttacks(std::countr_zero(bb), occupied));
+    for (uint64_t bb = queens; bb; bb &= bb - 1)
+        addAttacks(queenAttacks(std::countr_zero(bb), occupied));
+    for (uint64_t bb = kings; bb; bb &= bb - 1)
+        addAttacks(KING_ATTACKS[std::countr_zero(bb)]);
+
+    return eval;
+}
 
+// Score from the point of view of the side to move
 int64_t Engine::evaluate(const Board& board)
 {
-    int64_t score = 0;
+    PawnEntry pawns;
+    evaluatePawns(board, pawns);
+    return evaluate(board, pawns);
+}
 
-    // Center squares: d4, e4, d5, e5
-    const int centerSquares[4][2] = { {3,3}, {3,4}, {4,3}, {4,4} };
-    const int centerBonus = 50; // Tune as desired
+// Leaves reached again by transposition, or searched again with another
+// window or depth, are answered from the thread's cache
+int64_t Engine::evaluate(SearchThread& thread)
+{
+    uint64_t key = thread.board.zobristHash();
+    int64_t score;
+    if (thread.evalCache.probe(key, score))
+        return score;
+    score = evaluate(thread.board, thread.pawns.probe(thread.board));
+    thread.evalCache.store(key, score);
+    return score;
+}
 
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Piece p = board.get(x, y);
-            if (p.type == PieceType::None) continue;
+int64_t Engine::evaluate(const Board& board, const PawnEntry& pawns)
+{
+    SideEval white = evaluateSide(board, pawns, Color::White);
+    SideEval black = evaluateSide(board, pawns, Color::Black);
+
+    // Material and piece-square sums are kept up to date by the board, the
+    // pawn terms come from the pawn entry; all are blended by game phase.
+    Score sums = board.material(Color::White) + board.pieceSquares(Color::White)
+        - board.material(Color::Black) - board.pieceSquares(Color::Black);
+    sums += pawns.score;
+    sums.mg += pawns.kingShelter(Color::White, std::countr_zero(board.white_kings))
+        - pawns.kingShelter(Color::Black, std::countr_zero(board.black_kings));
+    int phase = std::min(board.gamePhase(), MAX_PHASE);
+    int64_t score = (int64_t(sums.mg) * phase + int64_t(sums.eg) * (MAX_PHASE - phase)) / MAX_PHASE;
+
+    score += white.score - black.score + 3 * (white.mobility - black.mobility);
+
+    // Pieces the opponent could win material against cost a little of what
+    // the exchange would win; playing it out is left to the quiescence search.
+    auto hangingPenalty = [&](uint64_t attacked, Color by)
+        {
+            int64_t penalty = 0;
+            for (; attacked; attacked &= attacked - 1) {
+                int sq = std::countr_zero(attacked);
+                int from = board.leastValuableAttacker(sq, by);
+                int gain = board.see(PackedMove(from, sq, PackedMove::Capture));
+                if (gain > 0)
+                    penalty += gain / 16;
+            }
+            return penalty;
+        };
+    uint64_t kings = board.white_kings | board.black_kings;
+    score -= hangingPenalty(board.whitePieces & ~kings & black.attacks, Color::Black);
+    score += hangingPenalty(board.blackPieces & ~kings & white.attacks, Color::White);
 
-            auto value = pieceValue(p.type);
-            auto pieceScore = (p.color == board.turn) ? value : -value;
+    return board.turn == Color::White ? score : -score;
+}
 
-            Square sq{ x, y };
-            Color pieceColor = p.color;
-            Color opponentColor = board.opposite(pieceColor);
+int64_t Engine::negamax(SearchThread& thread, int depth, int ply, int64_t alpha, int64_t beta)
+{
+    Board& board = thread.board;
+    thread.pvLength[ply] = 0;
 
-            // PSTs
-            if (p.type == PieceType::Pawn) {
-                int pstY = (p.color == Color::White) ? y : 7 - y;
-                int pstX = x;
-                pieceScore += pawnPST[pstY][pstX];
-            }
+    // A repeated position, or fifty reversible moves that did not end in
+    // mate, is a draw however it is searched, and the cycle behind it need
+    // not be
+    if (board.isDraw())
+        return 0;
 
-            // Pawn structure
-            // Example: Penalty for doubled pawns
-            for (int file = 0; file < 8; ++file) {
-                int whitePawns = 0, blackPawns = 0;
-                for (int rank = 0; rank < 8; ++rank) {
-                    Piece p = board.get(file, rank);
-                    if (p.type == PieceType::Pawn) {
-                        if (p.color == Color::White) whitePawns++;
-                        else blackPawns++;
-                    }
-                }
-                if (whitePawns > 1) score -= 20 * (whitePawns - 1);
-                if (blackPawns > 1) score += 20 * (blackPawns - 1);
-            }
+    if (depth <= 0)
+        return quiescence(thread, ply, alpha, beta);
 
-            // King safety
-            // Example: Bonus for castled king
-            if (board.whiteKingside || board.whiteQueenside)
-                score += 300;
-            if (board.blackKingside || board.blackQueenside)
-                score -= 300;
-
-            // Mobility
-            Board bb = board;
-            auto whiteMobility = bb.generateLegalMoves(Color::White).size();
-            auto blackMobility = bb.generateLegalMoves(Color::Black).size();
-            score += 3 * (whiteMobility - blackMobility);
-
-
-            // 5. Bishop Pair Bonus
-            int whiteBishops = 0, blackBishops = 0;
-            for (int y = 0; y < 8; ++y)
-                for (int x = 0; x < 8; ++x) {
-                    Piece p = board.get(x, y);
-                    if (p.type == PieceType::Bishop) {
-                        if (p.color == Color::White) whiteBishops++;
-                        else blackBishops++;
-                    }
-                }
-            if (whiteBishops >= 2) score += 300;
-            if (blackBishops >= 2) score -= 300;
+    SearchStack& ss = thread.stack[ply];
+    // Only nodes searched with an open window can change the PV
+    bool pvNode = beta - alpha > 1;
 
+    // Results are thrown away once stopped, so unwind straight away
+    if (stopped.load(std::memory_order_relaxed))
+        return 0;
+    countNode(thread);
 
-            // Center control bonus for pawns and knights
-            if (p.type == PieceType::Pawn || p.type == PieceType::Knight) {
-                for (const auto& sq : centerSquares) {
-                    if (x == sq[0] && y == sq[1]) {
-                        pieceScore += (p.color == board.turn) ? centerBonus : -centerBonus;
-                        break;
-                    }
-                }
-            }
+    // 1. Transposition Table Lookup. PV nodes search on so that the line
+    // they return is complete.
+    uint64_t hash = board.zobristHash();
+    PackedMove ttMove{};
+    TTEntry entry;
+    if (transTable.probe(hash, entry)) {
+        ttMove = entry.move;
+        if (!pvNode && entry.depth >= depth) {
+            int64_t score = scoreFromTT(entry.score, ply);
+            if (entry.flag == TTFlag::Exact
+                || (entry.flag == TTFlag::Lower && score >= beta)
+                || (entry.flag == TTFlag::Upper && score <= alpha))
+                return score;
+        }
+    }
 
-            // Square sq{ x, y };
-            bool attacked = board.isSquareAttacked(sq, opponentColor);
+    if (ply >= MAX_PLY)
+        return evaluate(thread);
+
+    Color side = board.getTurn();
+    bool inCheck = board.isInCheck(side);
+    thread.stack[ply + 1].killers = {};
+
+    // 2. Null move: if passing still fails high, a real move will too.
+    // Never twice in a row, in check, or with only pawns left. Near mate
+    // scores the bound is meaningless, and at high depth or with little
+    // material the cutoff is confirmed by a reduced search without nulls.
+    const SearchParams& params = searchParams;
+    int64_t material = pieceMaterial(board, side);
+    if (params.nullMove && !pvNode && !inCheck && depth >= params.nullMinDepth && ply >= thread.nullMinPly
+        && !thread.stack[ply - 1].move.isNull() && material > 0 && std::abs(beta) < MATE_BOUND
+        && evaluate(thread) >= beta) {
+        int r = params.nullReduction + (depth - params.nullMinDepth) / 4;
+        ss.move = PackedMove{};
+        board.makeNullMove();
+        auto eval = -negamax(thread, depth - 1 - r, ply + 1, -beta, -beta + 1);
+        board.undoMove();
+        if (stopped.load(std::memory_order_relaxed))
+            return 0;
+
+        if (eval >= beta) {
+            bool verify = depth >= params.nullVerifyDepth
+                || material <= PIECE_SCORE[static_cast<int>(PieceType::Bishop)].mg;
+            if (!verify)
+                return eval >= MATE_BOUND ? beta : eval;
+
+            int savedMinPly = thread.nullMinPly;
+            thread.nullMinPly = ply + 1 + 3 * (depth - r) / 4;
+            auto verified = negamax(thread, depth - r, ply, beta - 1, beta);
+            thread.nullMinPly = savedMinPly;
+            if (verified >= beta)
+                return verified >= MATE_BOUND ? beta : verified;
+        }
+    }
 
-            if (attacked) {
-                bool defended = board.isSquareAttacked(sq, pieceColor);
-                if (!defended) {
-                    score =  -(value * 100);
-                    return score;
-                }
+    // 3. Moves come from the picker, best candidates first
+    MovePicker picker(board, ttMove, ss.killers, thread.history);
+    ss.ttMove = ttMove;
+    thread.pvLength[ply] = 0;
+
+    int64_t alphaOrig = alpha;
+    int64_t bestValue = -INFINITE_SCORE;
+    PackedMove bestMove{};
+    int moveCount = 0;
+    MoveList quietsTried;
+    for (PackedMove move = picker.next(); !move.isNull(); move = picker.next()) {
+        ++moveCount;
+        bool quiet = !move.isCapture() && !move.isPromotion();
+        transTable.prefetch(board.keyAfter(move));
+        ss.move = move;
+        board.makeMove(move);
+
+        // Principal variation search: after the first move a null window
+        // only has to show a move is no better. Late quiet moves are also
+        // searched shallower, less so for moves with a good history. Either
+        // shortcut is searched again in full when the move beats alpha.
+        int64_t eval;
+        if (moveCount == 1) {
+            eval = -negamax(thread, depth - 1, ply + 1, -beta, -alpha);
+        }
+        else {
+            int r = 0;
+            if (params.lateMoveReductions && quiet && !inCheck && depth >= params.lmrMinDepth
+                && moveCount > params.lmrFullMoves && !board.isInCheck(board.getTurn())) {
+                r = reduction(depth, moveCount) - (pvNode ? 1 : 0);
+                r -= thread.history.get(side, move) / (HistoryTable::HISTORY_MAX / 2);
+                r = std::clamp(r, 0, depth - 2);
             }
+            eval = -negamax(thread, depth - 1 - r, ply + 1, -alpha - 1, -alpha);
+            if (r > 0 && eval > alpha)
+                eval = -negamax(thread, depth - 1, ply + 1, -alpha - 1, -alpha);
+            if (eval > alpha && eval < beta)
+                eval = -negamax(thread, depth - 1, ply + 1, -beta, -alpha);
+        }
+        board.undoMove();
+        if (eval > bestValue) {
+            bestValue = eval;
+            bestMove = move;
+        }
+        if (eval > alpha) {
+            alpha = eval;
+            if (pvNode)
+                updatePv(thread, ply, move);
+        }
 
-            score += pieceScore;
+        if (alpha >= beta) {
+            // A quiet move that refutes becomes a killer and gains history;
+            // the quiet moves tried before it lose some
+            if (quiet) {
+                if (ss.killers[0] != move) {
+                    ss.killers[1] = ss.killers[0];
+                    ss.killers[0] = move;
+                }
+                int32_t bonus = std::min(16 * depth * depth, 1600);
+                thread.history.update(side, move, bonus);
+                for (const auto& tried : quietsTried)
+                    thread.history.update(side, tried, -bonus);
+            }
+            break; // Beta cutoff
         }
+        if (quiet)
+            quietsTried.push_back(move);
     }
-    return score;
+
+    // 4. No legal moves: mate or stalemate
+    if (moveCount == 0)
+        return inCheck ? -MATE_SCORE + ply : 0;
+
+    if (stopped.load(std::memory_order_relaxed))
+        return 0;
+
+    // 5. Store in Transposition Table with the bound the window gave
+    TTFlag flag = bestValue <= alphaOrig ? TTFlag::Upper
+        : bestValue >= beta ? TTFlag::Lower
+        : TTFlag::Exact;
+    transTable.store(hash, flag == TTFlag::Upper ? PackedMove{} : bestMove,
+        scoreToTT(bestValue, ply), depth, flag);
+    return bestValue;
+}
+
+void Engine::countNode(SearchThread& thread)
+{
+    uint64_t nodes = thread.nodes.load(std::memory_order_relaxed) + 1;
+    thread.nodes.store(nodes, std::memory_order_relaxed);
+    if (thread.id == 0 && (nodes & 1023) == 0)
+        checkLimits();
 }
 
-int64_t Engine::minimax(Board& board, int depth, int64_t alpha, int64_t beta, bool maximizingPlayer)
+// Searches captures and promotions until the position is quiet, so that the
+// static evaluation is never taken in the middle of an exchange. The side to
+// move may stand pat on the evaluation instead of capturing, except in check
+// where every evasion is searched.
+int64_t Engine::quiescence(SearchThread& thread, int ply, int64_t alpha, int64_t beta)
 {
-    // 1. Transposition Table Lookup
+    Board& board = thread.board;
+    thread.pvLength[ply] = 0;
+    if (stopped.load(std::memory_order_relaxed))
+        return 0;
+    countNode(thread);
+
+    // Every stored entry is at least as deep as this
     uint64_t hash = board.zobristHash();
-    auto it = transTable.find(hash);
-    if (it != transTable.end() && it->second.depth >= depth) {
-        return it->second.value;
+    PackedMove ttMove{};
+    TTEntry entry;
+    if (transTable.probe(hash, entry)) {
+        ttMove = entry.move;
+        int64_t score = scoreFromTT(entry.score, ply);
+        if (entry.flag == TTFlag::Exact
+            || (entry.flag == TTFlag::Lower && score >= beta)
+            || (entry.flag == TTFlag::Upper && score <= alpha))
+            return score;
     }
 
-    // 2. Terminal Node or Depth Limit
-    Color currentSide = maximizingPlayer ? board.getTurn() : board.opposite(board.getTurn());
-    if (depth == 0 || board.isCheckmate(currentSide)) {
-        auto eval = evaluate(board);
-        // Store in TT
-        transTable[hash] = { depth, eval };
-        return eval;
+    if (ply >= MAX_PLY)
+        return evaluate(thread);
+
+    bool inCheck = board.isInCheck(board.getTurn());
+    int64_t alphaOrig = alpha;
+    int64_t standPat = -INFINITE_SCORE;
+    int64_t bestValue = -INFINITE_SCORE;
+    if (!inCheck) {
+        standPat = evaluate(thread);
+        if (standPat >= beta)
+            return standPat;
+        alpha = std::max(alpha, standPat);
+        bestValue = standPat;
     }
 
-    // 3. Generate and Order Moves
-    std::vector<Move> moves = board.generateLegalMoves(currentSide);
-    orderMoves(board, moves);
-
-    int64_t bestValue;
-    if (maximizingPlayer) {
-        bestValue = std::numeric_limits<int64_t>::min();
-        for (const auto& move : moves) {
-            Board next = board;
-            next.makeMove(move);
-            auto eval = minimax(next, depth - 1, alpha, beta, false);
-            bestValue = std::max(bestValue, eval);
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha)
-                break; // Beta cutoff
+    // Captures that lose material never leave the picker
+    MovePicker picker(board, ttMove, thread.history);
+    PackedMove bestMove{};
+    int moveCount = 0;
+    for (PackedMove move = picker.next(); !move.isNull(); move = picker.next()) {
+        ++moveCount;
+
+        // Delta pruning: skip a capture that could not lift the score to
+        // alpha even if the captured piece came for free
+        if (!inCheck && !move.isPromotion()) {
+            PieceType victim = move.isEnPassant() ? PieceType::Pawn : board.pieceOn(move.to()).type;
+            if (standPat + pieceValue(victim) + DELTA_MARGIN <= alpha)
+                continue;
         }
-    }
-    else {
-        bestValue = std::numeric_limits<int64_t>::max();
-        for (const auto& move : moves) {
-            Board next = board;
-            next.makeMove(move);
-            int64_t eval = minimax(next, depth - 1, alpha, beta, true);
-            bestValue = std::min(bestValue, eval);
-            beta = std::min(beta, eval);
-            if (beta <= alpha)
-                break; // Alpha cutoff
+
+        board.makeMove(move);
+        auto eval = -quiescence(thread, ply + 1, -beta, -alpha);
+        board.undoMove();
+        if (eval > bestValue) {
+            bestValue = eval;
+            bestMove = move;
         }
+        alpha = std::max(alpha, eval);
+        if (alpha >= beta)
+            break;
     }
 
-    // 4. Store in Transposition Table
-    transTable[hash] = { depth, bestValue };
+    // Every evasion was searched, so none means mate
+    if (inCheck && moveCount == 0)
+        return -MATE_SCORE + ply;
+
+    if (stopped.load(std::memory_order_relaxed))
+        return 0;
+
+    TTFlag flag = bestValue <= alphaOrig ? TTFlag::Upper
+        : bestValue >= beta ? TTFlag::Lower
+        : TTFlag::Exact;
+    transTable.store(hash, flag == TTFlag::Upper ? PackedMove{} : bestMove,
+        scoreToTT(bestValue, ply), 0, flag);
     return bestValue;
 }
@@ -1,13 +1,191 @@
 // engine.h
 #pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "board.h"
+#include "evalcache.h"
+#include "movepicker.h"
+#include "pawns.h"
+#include "timeman.h"
+#include "tt.h"
+
+// Deepest ply the search stack has room for
+constexpr int MAX_PLY = 128;
+
+// Per-ply search data, indexed by distance from the root
+struct SearchStack {
+    PackedMove move{};      // move made at this ply to reach the child
+    PackedMove ttMove{};
+    std::array<PackedMove, 2> killers{};  // quiet moves that refuted siblings
+};
+
+// Selectivity of the search, set through engine options. Depths are in
+// plies; the LMR formula is in hundredths of a ply.
+struct SearchParams {
+    bool nullMove = true;
+    int nullMinDepth = 3;       // shallowest remaining depth a null move is tried at
+    int nullReduction = 3;      // R, plus one for every further 4 plies of depth
+    int nullVerifyDepth = 12;   // from here on a null move cutoff is verified
+    bool lateMoveReductions = true;
+    int lmrMinDepth = 3;
+    int lmrFullMoves = 3;       // moves searched to full depth before reducing
+    int lmrBase = 75;           // reduction = base + ln(depth) * ln(moves) / divisor
+    int lmrDivisor = 225;
+};
+
+// Per-thread search state. Every thread searches its own copy of the root,
+// making and unmaking moves on it rather than copying it per child.
+struct SearchThread {
+    int id = 0;
+    Board board;
+    std::array<SearchStack, MAX_PLY + 2> stack{};
+    HistoryTable history;
+    PawnHashTable pawns;
+    EvalCache evalCache;
+    // Null moves are not tried below this ply while a cutoff is verified
+    int nullMinPly = 0;
+    // Triangular PV table: pv[ply] holds pvLength[ply] moves, the best line
+    // found so far from that ply on
+    std::array<std::array<PackedMove, MAX_PLY + 2>, MAX_PLY + 2> pv{};
+    std::array<int, MAX_PLY + 2> pvLength{};
+    // Principal variation of the last completed iteration
+    std::vector<PackedMove> bestLine;
+    // Written only by its own thread, read by the main thread for limits
+    std::atomic<uint64_t> nodes{ 0 };
+    int completedDepth = 0;
+    PackedMove bestMove{};
+    int64_t bestScore = 0;
+};
+
+struct SearchResult {
+    Move bestMove;
+    int64_t score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t time = 0;  // milliseconds
+    std::vector<PackedMove> pv;
+};
 
 class Engine {
 public:
+    // Scores beyond MATE_BOUND are forced mates, MATE_SCORE - |score| plies away
+    static constexpr int64_t MATE_SCORE = 100000000;
+    static constexpr int64_t MATE_BOUND = MATE_SCORE - 1000;
+    static constexpr int64_t INFINITE_SCORE = MATE_SCORE + 1;
+    static constexpr int MAX_DEPTH = 64;
+    // Ordering score above every quiet move for captures that do not lose
+    static constexpr int64_t GOOD_CAPTURE = 1000000;
+    // Margin on top of a captured piece's value before a capture is pruned
+    static constexpr int64_t DELTA_MARGIN = 200;
+    // Half-width of the first window around the previous iteration's score
+    static constexpr int64_t ASPIRATION_WINDOW = 25;
+    static constexpr int ASPIRATION_MIN_DEPTH = 4;
+
+    Engine();
+    ~Engine();
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Number of search threads, the calling thread included. Helpers are
+    // started here and sleep between searches.
+    void setThreads(int count);
+    int threadCount() const { return static_cast<int>(workers.size()); }
+
+    // Searches until a limit in SearchLimits is reached or stop() is called,
+    // and returns the best move of the last completed iteration. Infinite and
+    // ponder searches do not return before stop() or ponderhit().
+    SearchResult search(Board& board, const SearchLimits& limits);
+    // Runs search() on a thread of its own and returns at once; done is
+    // called on that thread with the result.
+    void startSearch(const Board& board, const SearchLimits& limits, std::function<void(const SearchResult&)> done);
+    // Returns once a search started by startSearch has finished
+    void waitForSearch();
+
+    // Safe to call from any thread while a search runs
+    void stop();
+    // The pondered move was played: the clock in the limits now applies
+    void ponderhit();
+
+    // Called on the searching thread after every iteration the main thread
+    // completes, with the result so far.
+    void setInfoHandler(std::function<void(const SearchResult&)> handler) { infoHandler = std::move(handler); }
+
+    // Not safe during a search
+    void setParams(const SearchParams& searchParams);
+    const SearchParams& params() const { return searchParams; }
+
+    // Fixed depth search; moves receives the root moves in search order and
+    // pv the principal variation, starting with the returned move
     Move findBestMove(Board& board, int depth, std::vector<Move>& moves);
+    Move findBestMove(Board& board, int depth, std::vector<Move>& moves, std::vector<PackedMove>& pv);
     int64_t evaluate(const Board& board);
 
+    // Size of the transposition table, and emptying it for a new game.
+    // Not safe during a search.
+    void setHashSize(size_t megabytes);
+    void clearHash();
+    // Permille of the transposition table in use by the current search
+    int hashfull() const { return transTable.hashfull(); }
+
+    // Size of each thread's evaluation cache. Not safe during a search.
+    void setEvalCacheSize(size_t kilobytes);
+
+    // Pawn hash and evaluation cache probes and hits of the last search,
+    // over all threads
+    uint64_t pawnProbes() const;
+    uint64_t pawnHits() const;
+    uint64_t evalCacheProbes() const;
+    uint64_t evalCacheHits() const;
+
 private:
-    int64_t minimax(Board& board, int depth, int64_t alpha, int64_t beta, bool maximizingPlayer);
-    void orderMoves(Board& board, std::vector<Move>& moves);
+    void helperLoop(SearchThread& thread);
+    void stopHelpers();
+    void checkLimits();
+    uint64_t totalNodes() const;
+    SearchResult runSearch(const Board& board, const SearchLimits& limits);
+    void waitForStop();
+    SearchResult currentResult(const SearchThread& thread);
+    void iterativeDeepening(SearchThread& thread, int maxDepth);
+    int64_t searchRoot(SearchThread& thread, int depth, int64_t alpha, int64_t beta, PackedMove& bestMove);
+    void countNode(SearchThread& thread);
+    int64_t evaluate(SearchThread& thread);
+    int64_t evaluate(const Board& board, const PawnEntry& pawns);
+    int64_t quiescence(SearchThread& thread, int ply, int64_t alpha, int64_t beta);
+    int64_t negamax(SearchThread& thread, int depth, int ply, int64_t alpha, int64_t beta);
+    void orderMoves(Board& board, MoveList& moves, PackedMove ttMove = PackedMove{});
+    int reduction(int depth, int moveCount) const;
+
+    // workers[0] is the thread calling findBestMove, the rest are helpers
+    std::vector<std::unique_ptr<SearchThread>> workers;
+    std::vector<std::thread> helpers;
+    std::thread searcher;
+    Board searchBoard;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    uint64_t searchId = 0;
+    int running = 0;
+    bool quit = false;
+
+    std::atomic<bool> stopped{ false };
+    std::atomic<bool> pondering{ false };
+    std::condition_variable stopSignal;
+    std::function<void(const SearchResult&)> infoHandler;
+    SearchLimits limits;
+    TimeManager timer;
+
+    // Shared by every search thread of this engine
+    TranspositionTable transTable;
+    SearchParams searchParams;
+    size_t evalCacheKb = EvalCache::DEFAULT_KB;
+    // Late move reductions by [depth][move number], in plies
+    std::array<std::array<uint8_t, 64>, 64> reductions{};
 };
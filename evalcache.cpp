@@ -0,0 +1,45 @@
+// evalcache.cpp
+#include <algorithm>
+
+#include "bitboard.h"
+#include "evalcache.h"
+
+EvalCache::EvalCache(size_t kilobytes)
+{
+    resize(kilobytes);
+}
+
+void EvalCache::resize(size_t kilobytes)
+{
+    size_t size = floorPow2(std::max<size_t>(kilobytes, 1) * 1024 / sizeof(Entry));
+
+    table = std::make_unique<Entry[]>(size);
+    count = size;
+    resetCounters();
+}
+
+void EvalCache::clear()
+{
+    std::fill(table.get(), table.get() + count, Entry{});
+    resetCounters();
+}
+
+// A slot never written has key zero, so a position whose key happens to be
+// zero is never answered from the cache
+bool EvalCache::probe(uint64_t key, int64_t& score)
+{
+    const Entry& entry = table[key & (count - 1)];
+    ++probeCount;
+    if (entry.key != key || key == 0)
+        return false;
+    ++hitCount;
+    score = entry.score;
+    return true;
+}
+
+void EvalCache::store(uint64_t key, int64_t score)
+{
+    Entry& entry = table[key & (count - 1)];
+    entry.key = key;
+    entry.score = score;
+}
@@ -0,0 +1,38 @@
+// evalcache.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Static evaluations by position key. Direct-mapped and owned by a single
+// search thread, so neither probes nor stores take a lock; a newer position
+// simply overwrites an older one in its slot.
+class EvalCache {
+public:
+    static constexpr size_t DEFAULT_KB = 1024;
+
+    explicit EvalCache(size_t kilobytes = DEFAULT_KB);
+
+    // Reallocates the cache, which also clears it
+    void resize(size_t kilobytes);
+    void clear();
+
+    bool probe(uint64_t key, int64_t& score);
+    void store(uint64_t key, int64_t score);
+
+    size_t entryCount() const { return count; }
+    uint64_t probes() const { return probeCount; }
+    uint64_t hits() const { return hitCount; }
+    void resetCounters() { probeCount = hitCount = 0; }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        int64_t score = 0;
+    };
+
+    std::unique_ptr<Entry[]> table;
+    size_t count = 0;
+    uint64_t probeCount = 0;
+    uint64_t hitCount = 0;
+};
@@ -0,0 +1,178 @@
+// fen.cpp
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+#include "fen.h"
+
+// Splits off the next space-separated field, empty when there are no more
+static std::string_view nextField(std::string_view& rest)
+{
+    size_t start = rest.find_first_not_of(" \t\r\n");
+    if (start == std::string_view::npos) {
+        rest = {};
+        return {};
+    }
+    rest.remove_prefix(start);
+    size_t end = std::min(rest.find_first_of(" \t\r\n"), rest.size());
+    auto field = rest.substr(0, end);
+    rest.remove_prefix(end);
+    return field;
+}
+
+static Piece pieceFromChar(char ch)
+{
+    Color color = (ch >= 'a' && ch <= 'z') ? Color::Black : Color::White;
+    switch (ch | 0x20) {
+        case 'p': return Piece{ PieceType::Pawn, color };
+        case 'n': return Piece{ PieceType::Knight, color };
+        case 'b': return Piece{ PieceType::Bishop, color };
+        case 'r': return Piece{ PieceType::Rook, color };
+        case 'q': return Piece{ PieceType::Queen, color };
+        case 'k': return Piece{ PieceType::King, color };
+        default: return Piece{ PieceType::None, Color::White };
+    }
+}
+
+static char pieceToChar(Piece piece)
+{
+    static const char letters[] = " pnbrqk";
+    char ch = letters[static_cast<int>(piece.type)];
+    return piece.color == Color::White ? static_cast<char>(ch - 'a' + 'A') : ch;
+}
+
+static int parseCount(std::string_view field)
+{
+    int value = 0;
+    auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (ec != std::errc() || end != field.data() + field.size())
+        throw std::runtime_error("Invalid fen file. Move count incorrect.");
+    return value;
+}
+
+void parseFen(std::string_view fen, Position& position)
+{
+    position = Position{};
+
+    auto placement = nextField(fen);
+    auto turn = nextField(fen);
+    auto castle = nextField(fen);
+    auto enPassant = nextField(fen);
+    auto half = nextField(fen);
+    auto full = nextField(fen);
+
+    // Board: rank 8 to 1
+    int rank = 7;
+    int file = 0;
+    for (char ch : placement) {
+        if (ch == '/') {
+            --rank;
+            file = 0;
+            continue;
+        }
+        if (ch >= '0' && ch <= '9') {
+            file += ch - '0';
+            continue;
+        }
+
+        Piece piece = pieceFromChar(ch);
+        if (piece.type == PieceType::None || file >= 8 || rank < 0)
+            throw std::runtime_error("Invalid FEN placement");
+        position.putPiece(piece, rank * 8 + file);
+        ++file;
+    }
+
+    if (turn != "w" && turn != "b")
+        throw std::runtime_error("Invalid fen file. Turn format incorrect.");
+    position.turn = turn[0] == 'w' ? Color::White : Color::Black;
+
+    if (castle.empty())
+        throw std::runtime_error("Invalid fen file. Castle incorrect.");
+    if (castle != "-") {
+        for (char ch : castle) {
+            switch (ch) {
+                case 'K': position.whiteKingside = true; break;
+                case 'Q': position.whiteQueenside = true; break;
+                case 'k': position.blackKingside = true; break;
+                case 'q': position.blackQueenside = true; break;
+                default: throw std::runtime_error("Invalid fen file. Castle incorrect.");
+            }
+        }
+    }
+
+    if (enPassant != "-") {
+        if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h'
+            || enPassant[1] < '1' || enPassant[1] > '8')
+            throw std::runtime_error("Invalid fen file. enpassant incorrect.");
+        position.enPassantTarget = Square{ enPassant[0] - 'a', enPassant[1] - '1' };
+    }
+
+    // The move counters are optional
+    if (!half.empty())
+        position.halfMoveClock = parseCount(half);
+    if (!full.empty())
+        position.fullMoveNumber = parseCount(full);
+}
+
+size_t writeFen(const Position& position, char* out)
+{
+    char* p = out;
+
+    // Board: rank 8 to 1
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            Piece piece = position.pieceOn(rank * 8 + file);
+            if (piece.type == PieceType::None) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                *p++ = static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            *p++ = pieceToChar(piece);
+        }
+        if (empty > 0)
+            *p++ = static_cast<char>('0' + empty);
+        if (rank > 0)
+            *p++ = '/';
+    }
+
+    *p++ = ' ';
+    *p++ = position.turn == Color::White ? 'w' : 'b';
+
+    *p++ = ' ';
+    char* castles = p;
+    if (position.whiteKingside) *p++ = 'K';
+    if (position.whiteQueenside) *p++ = 'Q';
+    if (position.blackKingside) *p++ = 'k';
+    if (position.blackQueenside) *p++ = 'q';
+    if (p == castles)
+        *p++ = '-';
+
+    *p++ = ' ';
+    if (position.enPassantTarget.x < 0) {
+        *p++ = '-';
+    }
+    else {
+        *p++ = static_cast<char>('a' + position.enPassantTarget.x);
+        *p++ = static_cast<char>('1' + position.enPassantTarget.y);
+    }
+
+    // Room is left for two full-width ints
+    char* end = out + MAX_FEN_LENGTH - 1;
+    *p++ = ' ';
+    p = std::to_chars(p, end, position.halfMoveClock).ptr;
+    *p++ = ' ';
+    p = std::to_chars(p, end, position.fullMoveNumber).ptr;
+    *p = '\0';
+    return static_cast<size_t>(p - out);
+}
+
+std::string toFen(const Position& position)
+{
+    char buffer[MAX_FEN_LENGTH];
+    size_t length = writeFen(position, buffer);
+    return std::string(buffer, length);
+}
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <iostream>
+#include <thread>
 #include "board.h"
 #include "bitboard.h"
 #include "engine.h"
@@ -25,6 +27,7 @@ int main()
 
     Board board;
     Engine engine;
+    engine.setThreads(std::max(1u, std::thread::hardware_concurrency()));
     board.reset();
 
     // Clear and set up the display
@@ -36,7 +39,7 @@ int main()
 
     bool end = false;
     std::vector<Move> moves;
-    board.turn = Color::Black;
+    board.setTurn(Color::Black);
     for (int moveCount = 0; !end; ++moveCount) {
         auto level = board.turn == Color::White ? white_level : black_level;
         auto move = engine.findBestMove(board, level, moves);
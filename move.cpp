@@ -6,10 +6,10 @@ std::string Move::toString() const
 {
     std::string str;
     str += from.toString();
-    str += (type == MoveType::Capture || type == MoveType::EnPassant) ? 'x' : '-';
+    str += (type == MoveType::Capture || type == MoveType::EnPassant || type == MoveType::PromotionCapture) ? 'x' : '-';
     str += to.toString();
 
-    if (type == MoveType::Promotion && promotionType != PieceType::None) {
+    if ((type == MoveType::Promotion || type == MoveType::PromotionCapture) && promotionType != PieceType::None) {
         str += '=';
         auto p = pieceTypeToCharLower(promotionType);
         str += p; // Youll need to implement this
@@ -22,10 +22,10 @@ std::string Move::toString(const Board& board) const
 {
     std::string str;
     str += from.toString();
-    str += (type == MoveType::Capture || type == MoveType::EnPassant ? 'x' : '-');
+    str += (type == MoveType::Capture || type == MoveType::EnPassant || type == MoveType::PromotionCapture ? 'x' : '-');
     str += to.toString();
 
-    if (type == MoveType::Promotion) {
+    if (type == MoveType::Promotion || type == MoveType::PromotionCapture) {
         auto piece = board.get(from.x, from.y);
         str += '=';
         str += piece.toString(); // assuming this returns correct letter case
@@ -33,3 +33,71 @@ std::string Move::toString(const Board& board) const
 
     return str;
 }
+
+Move::Move(PackedMove pm)
+    : from({ pm.from() % 8, pm.from() / 8 }), to({ pm.to() % 8, pm.to() / 8 })
+{
+    if (pm.isPromotion()) {
+        type = pm.isCapture() ? MoveType::PromotionCapture : MoveType::Promotion;
+        promotionType = pm.promotionType();
+    }
+    else if (pm.isEnPassant()) {
+        type = MoveType::EnPassant;
+    }
+    else if (pm.isCastle()) {
+        type = MoveType::Castle;
+    }
+    else if (pm.isCapture()) {
+        type = MoveType::Capture;
+    }
+    else if (pm.flags() == PackedMove::DoublePush) {
+        type = MoveType::DoublePush;
+    }
+}
+
+PackedMove::PackedMove(const Move& move)
+{
+    int fromIndex = move.from.y * 8 + move.from.x;
+    int toIndex = move.to.y * 8 + move.to.x;
+    int flags = Quiet;
+
+    switch (move.type) {
+        case MoveType::Promotion:
+        case MoveType::PromotionCapture:
+            flags = promotionFlag(move.promotionType == PieceType::None ? PieceType::Queen : move.promotionType,
+                move.type == MoveType::PromotionCapture);
+            break;
+        case MoveType::EnPassant:
+            flags = EnPassant;
+            break;
+        case MoveType::Castle:
+            flags = move.to.x == 6 ? KingCastle : QueenCastle;
+            break;
+        case MoveType::Capture:
+            flags = Capture;
+            break;
+        case MoveType::DoublePush:
+            flags = DoublePush;
+            break;
+        default:
+            break;
+    }
+    *this = PackedMove(fromIndex, toIndex, flags);
+}
+
+std::string PackedMove::toString() const
+{
+    return Move(*this).toString();
+}
+
+std::string PackedMove::toUci() const
+{
+    if (isNull())
+        return "0000";
+
+    Move move(*this);
+    std::string str = move.from.toString() + move.to.toString();
+    if (isPromotion())
+        str += move.pieceTypeToCharLower(promotionType());
+    return str;
+}
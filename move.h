@@ -1,7 +1,9 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 class Board;
+struct PackedMove;
 
 enum class MoveType {
     Normal,
@@ -9,6 +11,8 @@ enum class MoveType {
     EnPassant,
     Castle,
     Capture,
+    DoublePush,
+    PromotionCapture,
 };
 
 struct Move {
@@ -46,7 +50,64 @@ public:
     }
 
     Move() : from({ -1, -1 }), to({ -1, -1 }) {}
+    explicit Move(PackedMove pm);
 
     std::string toString() const;
     std::string toString(const Board& board) const;
 };
+
+// 16-bit move used by the generator, move lists and undo records.
+// Bits 0-5 hold the from-square, 6-11 the to-square (index y * 8 + x)
+// and 12-15 the flags below. Ordering scores are kept beside the move,
+// in MoveList, not inside it.
+struct PackedMove {
+    enum Flags : uint16_t {
+        Quiet = 0,
+        DoublePush = 1,
+        KingCastle = 2,
+        QueenCastle = 3,
+        Capture = 4,
+        EnPassant = 5,
+        Promotion = 8,          // + 0..3 for knight, bishop, rook, queen
+        PromotionCapture = 12,  // + 0..3 as above
+    };
+
+    uint16_t data;          // left uninitialized by default; PackedMove{} is the null move
+
+    PackedMove() = default;
+    constexpr PackedMove(int from, int to, int flags = Quiet)
+        : data(static_cast<uint16_t>(from | (to << 6) | (flags << 12)))
+    {
+    }
+    explicit PackedMove(const Move& move);
+
+    constexpr int from() const { return data & 0x3F; }
+    constexpr int to() const { return (data >> 6) & 0x3F; }
+    constexpr int flags() const { return data >> 12; }
+
+    constexpr bool isCapture() const { return (flags() & Capture) != 0; }
+    constexpr bool isPromotion() const { return (flags() & Promotion) != 0; }
+    constexpr bool isEnPassant() const { return flags() == EnPassant; }
+    constexpr bool isCastle() const { return flags() == KingCastle || flags() == QueenCastle; }
+    constexpr bool isNull() const { return data == 0; }
+
+    PieceType promotionType() const
+    {
+        return isPromotion() ? static_cast<PieceType>(static_cast<int>(PieceType::Knight) + (flags() & 3))
+            : PieceType::None;
+    }
+
+    static constexpr int promotionFlag(PieceType pt, bool capture)
+    {
+        return (capture ? PromotionCapture : Promotion) + (static_cast<int>(pt) - static_cast<int>(PieceType::Knight));
+    }
+
+    constexpr bool operator==(const PackedMove& other) const { return data == other.data; }
+    constexpr bool operator!=(const PackedMove& other) const { return data != other.data; }
+
+    std::string toString() const;
+    // Long algebraic notation as UCI uses it, e.g. e7e8q; 0000 for the null move
+    std::string toUci() const;
+};
+
+static_assert(sizeof(PackedMove) == 2, "PackedMove must stay 16 bits");
@@ -0,0 +1,87 @@
+// movelist.h
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "chesstypes.h"
+#include "square.h"
+#include "move.h"
+
+// Fixed-capacity move container that lives on the stack. No legal chess
+// position has more than 218 moves, so 256 slots never overflow and move
+// generation never touches the heap. Moves are stored packed; the ordering
+// score of each move sits in a parallel array so the moves themselves stay
+// in a few cache lines.
+class MoveList {
+public:
+    static constexpr size_t MAX_MOVES = 256;
+
+    using value_type = PackedMove;
+    using iterator = PackedMove*;
+    using const_iterator = const PackedMove*;
+
+    void push_back(PackedMove move)
+    {
+        assert(count < MAX_MOVES);
+        moves[count++] = move;
+    }
+
+    void emplace_back(int from, int to, int flags = PackedMove::Quiet)
+    {
+        assert(count < MAX_MOVES);
+        moves[count++] = PackedMove(from, to, flags);
+    }
+
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    PackedMove& operator[](size_t i) { return moves[i]; }
+    const PackedMove& operator[](size_t i) const { return moves[i]; }
+
+    int32_t& score(size_t i) { return scores[i]; }
+    int32_t score(size_t i) const { return scores[i]; }
+
+    // Sorts moves by descending score, keeping equal scores in generation
+    // order. Lists are short, so insertion sort beats std::sort here.
+    void sortByScore()
+    {
+        for (size_t i = 1; i < count; ++i) {
+            auto move = moves[i];
+            auto s = scores[i];
+            size_t j = i;
+            for (; j > 0 && scores[j - 1] < s; --j) {
+                moves[j] = moves[j - 1];
+                scores[j] = scores[j - 1];
+            }
+            moves[j] = move;
+            scores[j] = s;
+        }
+    }
+
+    // Brings the best scored move from index on to index, for picking moves
+    // one at a time without sorting the rest
+    void moveBestTo(size_t index)
+    {
+        size_t best = index;
+        for (size_t i = index + 1; i < count; ++i) {
+            if (scores[i] > scores[best])
+                best = i;
+        }
+        std::swap(moves[index], moves[best]);
+        std::swap(scores[index], scores[best]);
+    }
+
+    iterator begin() { return moves.data(); }
+    iterator end() { return moves.data() + count; }
+    const_iterator begin() const { return moves.data(); }
+    const_iterator end() const { return moves.data() + count; }
+
+private:
+    std::array<PackedMove, MAX_MOVES> moves;
+    std::array<int32_t, MAX_MOVES> scores;
+    size_t count = 0;
+};
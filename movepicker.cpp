@@ -0,0 +1,175 @@
+// movepicker.cpp
+#include <algorithm>
+#include <cstdlib>
+
+#include "movepicker.h"
+
+void HistoryTable::update(Color side, PackedMove move, int32_t bonus)
+{
+    int32_t& entry = table[side == Color::White ? 0 : 1][move.from()][move.to()];
+    bonus = std::clamp(bonus, -HISTORY_MAX, HISTORY_MAX);
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+void HistoryTable::clear()
+{
+    for (auto& side : table)
+        for (auto& from : side)
+            from.fill(0);
+}
+
+void HistoryTable::age()
+{
+    for (auto& side : table)
+        for (auto& from : side)
+            for (auto& entry : from)
+                entry /= 2;
+}
+
+// Most valuable victim first, least valuable attacker breaking ties;
+// promotions count the new piece as part of the gain
+static int32_t mvvLva(const Board& board, PackedMove move)
+{
+    int victim = move.isEnPassant() ? static_cast<int>(PieceType::Pawn)
+        : static_cast<int>(board.pieceOn(move.to()).type);
+    int attacker = static_cast<int>(board.pieceOn(move.from()).type);
+    int promotion = static_cast<int>(move.promotionType());
+    return (victim + promotion) * 8 - attacker;
+}
+
+MovePicker::MovePicker(const Board& board, PackedMove ttMove, const std::array<PackedMove, 2>& killers, const HistoryTable& history)
+    : board(board), history(history), ttMove(ttMove), killers(killers), stage(Stage::TTMove)
+{
+}
+
+MovePicker::MovePicker(const Board& board, PackedMove ttMove, const HistoryTable& history)
+    : board(board), history(history), ttMove(ttMove),
+    stage(board.isInCheck(board.getTurn()) ? Stage::EvasionTTMove : Stage::QuiescenceTTMove)
+{
+    // Quiet table moves are of no use when only captures are searched
+    if (stage == Stage::QuiescenceTTMove && !ttMove.isCapture() && !ttMove.isPromotion())
+        this->ttMove = PackedMove{};
+}
+
+void MovePicker::scoreCaptures()
+{
+    for (size_t i = 0; i < moves.size(); ++i)
+        moves.score(i) = mvvLva(board, moves[i]);
+}
+
+void MovePicker::scoreQuiets()
+{
+    Color side = board.getTurn();
+    for (size_t i = 0; i < moves.size(); ++i)
+        moves.score(i) = history.get(side, moves[i]);
+}
+
+void MovePicker::scoreEvasions()
+{
+    // Captures of the checker before king moves and blocks
+    Color side = board.getTurn();
+    for (size_t i = 0; i < moves.size(); ++i) {
+        PackedMove move = moves[i];
+        moves.score(i) = (move.isCapture() || move.isPromotion())
+            ? HistoryTable::HISTORY_MAX * 2 + mvvLva(board, move)
+            : history.get(side, move);
+    }
+}
+
+PackedMove MovePicker::next()
+{
+    for (;;) {
+        switch (stage) {
+            case Stage::TTMove:
+            case Stage::QuiescenceTTMove:
+            case Stage::EvasionTTMove:
+                stage = static_cast<Stage>(static_cast<int>(stage) + 1);
+                if (board.isPseudoLegal(ttMove) && board.isLegal(ttMove))
+                    return ttMove;
+                ttMove = PackedMove{};
+                break;
+
+            case Stage::GenerateCaptures:
+            case Stage::GenerateQuiescence:
+                moves.clear();
+                board.generateLegalCaptures(board.getTurn(), moves);
+                scoreCaptures();
+                current = 0;
+                stage = static_cast<Stage>(static_cast<int>(stage) + 1);
+                break;
+
+            case Stage::GoodCaptures:
+            case Stage::QuiescenceCaptures:
+                while (current < moves.size()) {
+                    moves.moveBestTo(current);
+                    PackedMove move = moves[current++];
+                    if (move == ttMove)
+                        continue;
+                    if (board.see(move) < 0) {
+                        // Kept for last in the main search, dropped in quiescence
+                        if (stage == Stage::GoodCaptures)
+                            badCaptures.push_back(move);
+                        continue;
+                    }
+                    return move;
+                }
+                stage = stage == Stage::GoodCaptures ? Stage::Killers : Stage::Done;
+                break;
+
+            case Stage::Killers:
+                while (killerIndex < killers.size()) {
+                    PackedMove move = killers[killerIndex++];
+                    if (move != ttMove && !move.isCapture() && !move.isPromotion()
+                        && board.isPseudoLegal(move) && board.isLegal(move))
+                        return move;
+                }
+                stage = Stage::GenerateQuiets;
+                break;
+
+            case Stage::GenerateQuiets:
+                moves.clear();
+                board.generateLegalQuiets(board.getTurn(), moves);
+                scoreQuiets();
+                current = 0;
+                stage = Stage::Quiets;
+                break;
+
+            case Stage::Quiets:
+                while (current < moves.size()) {
+                    moves.moveBestTo(current);
+                    PackedMove move = moves[current++];
+                    if (move != ttMove && !isKiller(move))
+                        return move;
+                }
+                stage = Stage::BadCaptures;
+                break;
+
+            case Stage::BadCaptures:
+                if (badCurrent < badCaptures.size())
+                    return badCaptures[badCurrent++];
+                stage = Stage::Done;
+                break;
+
+            case Stage::GenerateEvasions:
+                moves.clear();
+                board.generateFullyLegalMoves(board.getTurn(), moves);
+                scoreEvasions();
+                current = 0;
+                stage = Stage::Evasions;
+                break;
+
+            case Stage::Evasions:
+                while (current < moves.size()) {
+                    moves.moveBestTo(current);
+                    PackedMove move = moves[current++];
+                    if (move != ttMove)
+                        return move;
+                }
+                stage = Stage::Done;
+                break;
+
+            case Stage::Done:
+                return PackedMove{};
+        }
+    }
+}
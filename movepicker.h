@@ -0,0 +1,71 @@
+// movepicker.h
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "board.h"
+#include "movelist.h"
+
+// How often each quiet move has caused a cutoff, by side, from and to
+// square. Updates pull the value toward the bonus so it saturates at
+// HISTORY_MAX instead of growing without bound.
+class HistoryTable {
+public:
+    static constexpr int32_t HISTORY_MAX = 16384;
+
+    int32_t get(Color side, PackedMove move) const
+    {
+        return table[side == Color::White ? 0 : 1][move.from()][move.to()];
+    }
+    void update(Color side, PackedMove move, int32_t bonus);
+    void clear();
+    // Halves every entry, so older searches count for less
+    void age();
+
+private:
+    std::array<std::array<std::array<int32_t, 64>, 64>, 2> table{};
+};
+
+// Hands out the moves of a node one at a time in the order they are most
+// likely to cause a cutoff, generating and scoring each group only once the
+// earlier ones are used up:
+//   the transposition table move, checked to be legal here,
+//   captures that do not lose material (SEE), most valuable victim first,
+//   the two killer moves of the ply,
+//   quiet moves by history,
+//   captures that lose material.
+// For the quiescence search only the winning and equal captures are given,
+// or every evasion when the side to move is in check.
+class MovePicker {
+public:
+    MovePicker(const Board& board, PackedMove ttMove, const std::array<PackedMove, 2>& killers, const HistoryTable& history);
+    MovePicker(const Board& board, PackedMove ttMove, const HistoryTable& history);
+
+    // The next move, or the null move once there are none left
+    PackedMove next();
+
+private:
+    enum class Stage {
+        TTMove, GenerateCaptures, GoodCaptures, Killers, GenerateQuiets, Quiets, BadCaptures,
+        QuiescenceTTMove, GenerateQuiescence, QuiescenceCaptures,
+        EvasionTTMove, GenerateEvasions, Evasions,
+        Done
+    };
+
+    void scoreCaptures();
+    void scoreQuiets();
+    void scoreEvasions();
+    bool isKiller(PackedMove move) const { return move == killers[0] || move == killers[1]; }
+
+    const Board& board;
+    const HistoryTable& history;
+    PackedMove ttMove;
+    std::array<PackedMove, 2> killers{};
+    Stage stage;
+
+    MoveList moves;
+    size_t current = 0;
+    MoveList badCaptures;
+    size_t badCurrent = 0;
+    size_t killerIndex = 0;
+};
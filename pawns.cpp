@@ -0,0 +1,142 @@
+// pawns.cpp
+#include <algorithm>
+#include <bit>
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "pawns.h"
+
+static const Score DOUBLED = { -10, -25 };
+static const Score ISOLATED = { -10, -15 };
+// By rank counted from the pawn's own side
+static const Score PASSED[8] = {
+    { 0, 0 }, { 5, 10 }, { 5, 15 }, { 10, 25 }, { 20, 45 }, { 35, 75 }, { 60, 120 }, { 0, 0 }
+};
+// Shield pawns one and two ranks in front of the king, and an open file
+static const int SHELTER_NEAR = 20;
+static const int SHELTER_FAR = 10;
+static const int SHELTER_OPEN = -15;
+
+static uint64_t northFill(uint64_t bb)
+{
+    bb |= bb << 8;
+    bb |= bb << 16;
+    bb |= bb << 32;
+    return bb;
+}
+
+static uint64_t southFill(uint64_t bb)
+{
+    bb |= bb >> 8;
+    bb |= bb >> 16;
+    bb |= bb >> 32;
+    return bb;
+}
+
+// Squares ahead of the pawns, from their own side's point of view
+static uint64_t frontSpan(uint64_t pawns, Color side)
+{
+    return side == Color::White ? northFill(pawns) << 8 : southFill(pawns) >> 8;
+}
+
+static uint64_t adjacentFiles(int file)
+{
+    uint64_t files = 0;
+    if (file > 0)
+        files |= FILE_A << (file - 1);
+    if (file < 7)
+        files |= FILE_A << (file + 1);
+    return files;
+}
+
+int PawnEntry::kingShelter(Color side, int sq) const
+{
+    // A side without a king, as in some test positions, passes square 64
+    if (sq < 0 || sq >= 64)
+        return 0;
+    int relativeRank = side == Color::White ? sq / 8 : 7 - sq / 8;
+    return relativeRank <= 1 ? shelter[side == Color::White ? 0 : 1][sq % 8] : 0;
+}
+
+void evaluatePawns(const Position& position, PawnEntry& entry)
+{
+    entry = PawnEntry{};
+    entry.key = position.pawnHash();
+
+    for (int c = 0; c < 2; ++c) {
+        Color side = c == 0 ? Color::White : Color::Black;
+        Color enemy = c == 0 ? Color::Black : Color::White;
+        uint64_t own = position.pieces(PieceType::Pawn, side);
+        uint64_t theirs = position.pieces(PieceType::Pawn, enemy);
+
+        entry.attacks[c] = pawnAttacks(own, side);
+        entry.attackSpan[c] = pawnAttacks(own | frontSpan(own, side), side);
+
+        // A pawn is passed once no enemy pawn can block or take it on its way
+        uint64_t stoppers = frontSpan(theirs, enemy) | pawnAttacks(theirs | frontSpan(theirs, enemy), enemy);
+
+        Score score;
+        for (int file = 0; file < 8; ++file) {
+            int count = std::popcount(own & (FILE_A << file));
+            if (count > 1)
+                score += Score{ DOUBLED.mg * (count - 1), DOUBLED.eg * (count - 1) };
+        }
+        for (uint64_t bb = own; bb; bb &= bb - 1) {
+            int sq = std::countr_zero(bb);
+            if (!(own & adjacentFiles(sq % 8)))
+                score += ISOLATED;
+            if (!((1ULL << sq) & stoppers)) {
+                entry.passed[c] |= 1ULL << sq;
+                score += PASSED[side == Color::White ? sq / 8 : 7 - sq / 8];
+            }
+        }
+        entry.score += c == 0 ? score : Score{} - score;
+
+        // Shelter for a king on each file, from the pawns on that file and
+        // its neighbours
+        int nearRank = side == Color::White ? 1 : 6;
+        int farRank = side == Color::White ? 2 : 5;
+        for (int kingFile = 0; kingFile < 8; ++kingFile) {
+            int shelter = 0;
+            for (int file = std::max(kingFile - 1, 0); file <= std::min(kingFile + 1, 7); ++file) {
+                uint64_t filePawns = own & (FILE_A << file);
+                if (filePawns & (RANK_1 << (8 * nearRank)))
+                    shelter += SHELTER_NEAR;
+                else if (filePawns & (RANK_1 << (8 * farRank)))
+                    shelter += SHELTER_FAR;
+                else if (!filePawns)
+                    shelter += SHELTER_OPEN;
+            }
+            entry.shelter[c][kingFile] = static_cast<int16_t>(shelter);
+        }
+    }
+}
+
+PawnHashTable::PawnHashTable(size_t entries)
+{
+    size_t size = floorPow2(entries);
+    table = std::make_unique<PawnEntry[]>(size);
+    count = size;
+    clear();
+}
+
+void PawnHashTable::clear()
+{
+    // Every slot starts as the pawnless position, whose key is zero
+    PawnEntry empty;
+    evaluatePawns(Position{}, empty);
+    std::fill(table.get(), table.get() + count, empty);
+    resetCounters();
+}
+
+const PawnEntry& PawnHashTable::probe(const Position& position)
+{
+    uint64_t key = position.pawnHash();
+    PawnEntry& entry = table[key & (count - 1)];
+    ++probeCount;
+    if (entry.key == key)
+        ++hitCount;
+    else
+        evaluatePawns(position, entry);
+    return entry;
+}
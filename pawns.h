@@ -0,0 +1,53 @@
+// pawns.h
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "chesstypes.h"
+#include "position.h"
+#include "psqt.h"
+
+// Everything the evaluation takes from the pawns alone. Pawn structure
+// changes far less often than the rest of the position, so entries are
+// cached under Position::pawnHash.
+struct PawnEntry {
+    uint64_t key = 0;
+    Score score;                            // doubled, isolated and passed pawns, White's view
+    std::array<uint64_t, 2> passed{};       // [color]
+    std::array<uint64_t, 2> attacks{};      // squares the pawns attack now
+    std::array<uint64_t, 2> attackSpan{};   // squares they could attack as they advance
+    std::array<std::array<int16_t, 8>, 2> shelter{};  // [color][king file], middlegame
+
+    // Shelter of a king on sq; only a king on its first two ranks has one,
+    // and an empty king bitboard (sq 64) has none
+    int kingShelter(Color side, int sq) const;
+};
+
+// Fills an entry from scratch
+void evaluatePawns(const Position& position, PawnEntry& entry);
+
+// Direct-mapped pawn structure cache. Each search thread has its own, so
+// probes take no locks and the hit counters are plain integers.
+class PawnHashTable {
+public:
+    static constexpr size_t DEFAULT_ENTRIES = 8192;
+
+    explicit PawnHashTable(size_t entries = DEFAULT_ENTRIES);
+
+    void clear();
+
+    // The entry for the position's pawns, evaluated on a miss
+    const PawnEntry& probe(const Position& position);
+
+    uint64_t probes() const { return probeCount; }
+    uint64_t hits() const { return hitCount; }
+    void resetCounters() { probeCount = hitCount = 0; }
+
+private:
+    std::unique_ptr<PawnEntry[]> table;
+    size_t count = 0;
+    uint64_t probeCount = 0;
+    uint64_t hitCount = 0;
+};
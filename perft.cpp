@@ -0,0 +1,104 @@
+// perft.cpp
+#include <fstream>
+#include <stdexcept>
+
+#include "perft.h"
+
+static void generateMoves(Board& board, MoveList& moves, bool filtered)
+{
+    if (filtered)
+        board.generateLegalMoves(board.getTurn(), moves);
+    else
+        board.generateFullyLegalMoves(board.getTurn(), moves);
+}
+
+uint64_t perft(Board& board, int depth, bool bulk, bool filtered)
+{
+    if (depth == 0)
+        return 1;
+
+    MoveList moves;
+    generateMoves(board, moves, filtered);
+    if (bulk && depth == 1)
+        return moves.size();
+
+    uint64_t nodes = 0;
+    for (const auto& move : moves) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1, bulk, filtered);
+        board.undoMove();
+    }
+    return nodes;
+}
+
+std::vector<std::pair<Move, uint64_t>> divide(Board& board, int depth, bool bulk, bool filtered)
+{
+    std::vector<std::pair<Move, uint64_t>> result;
+    if (depth < 1)
+        return result;
+
+    MoveList moves;
+    generateMoves(board, moves, filtered);
+    for (const auto& move : moves) {
+        board.makeMove(move);
+        result.emplace_back(Move(move), perft(board, depth - 1, bulk, filtered));
+        board.undoMove();
+    }
+    return result;
+}
+
+static std::string_view trim(std::string_view s)
+{
+    auto first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos)
+        return {};
+    auto last = s.find_last_not_of(" \t\r\n");
+    return s.substr(first, last - first + 1);
+}
+
+bool parsePerftEntry(std::string_view line, PerftEntry& entry)
+{
+    entry.fen.clear();
+    entry.expected.clear();
+
+    line = trim(line);
+    if (line.empty() || line[0] == '#')
+        return false;
+
+    auto semi = line.find(';');
+    entry.fen = std::string(trim(line.substr(0, semi)));
+
+    while (semi != std::string_view::npos) {
+        line = line.substr(semi + 1);
+        semi = line.find(';');
+        auto field = trim(line.substr(0, semi));
+
+        // Fields look like "D5 4865609"
+        if (field.size() < 4 || field[0] != 'D')
+            continue;
+        auto space = field.find(' ');
+        if (space == std::string_view::npos)
+            continue;
+
+        auto depth = std::stoi(std::string(field.substr(1, space - 1)));
+        auto nodes = std::stoull(std::string(trim(field.substr(space + 1))));
+        entry.expected.emplace_back(depth, nodes);
+    }
+    return !entry.fen.empty();
+}
+
+std::vector<PerftEntry> loadPerftSuite(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("Unable to open perft suite: " + path);
+
+    std::vector<PerftEntry> suite;
+    std::string line;
+    PerftEntry entry;
+    while (std::getline(in, line)) {
+        if (parsePerftEntry(line, entry))
+            suite.push_back(entry);
+    }
+    return suite;
+}
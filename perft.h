@@ -0,0 +1,27 @@
+// perft.h
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+
+// Counts the leaf nodes of the legal move tree below the current position.
+// With bulk counting the last ply returns the size of the legal move list
+// instead of making and unmaking every leaf move. Moves come from the fully
+// legal generator; filtered selects the make/check/undo reference generator.
+uint64_t perft(Board& board, int depth, bool bulk = true, bool filtered = false);
+
+// Same as perft, but reports the subtree size of every root move.
+std::vector<std::pair<Move, uint64_t>> divide(Board& board, int depth, bool bulk = true, bool filtered = false);
+
+// One line of an EPD perft suite: "<fen> ;D1 20 ;D2 400 ..."
+struct PerftEntry {
+    std::string fen;
+    std::vector<std::pair<int, uint64_t>> expected; // depth, node count
+};
+
+bool parsePerftEntry(std::string_view line, PerftEntry& entry);
+std::vector<PerftEntry> loadPerftSuite(const std::string& path);
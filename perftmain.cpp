@@ -0,0 +1,145 @@
+// perftmain.cpp
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "board.h"
+#include "perft.h"
+
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct PerftOptions {
+    std::string fen = START_FEN;
+    std::string epd;
+    int depth = 0;
+    bool divide = false;
+    bool bulk = true;
+    bool filtered = false;
+};
+
+static void usage()
+{
+    std::cout <<
+        "usage: perft [options]\n"
+        "  --fen \"<fen>\"   position to count (default: start position)\n"
+        "  --depth N       search depth (default 5; caps each entry with --epd)\n"
+        "  --divide        print the node count below every root move\n"
+        "  --epd <file>    run an EPD suite and compare against its ;Dn counts\n"
+        "  --no-bulk       make every leaf move instead of counting the leaf list\n"
+        "  --filtered      use the make/check/undo reference generator\n";
+}
+
+static void report(uint64_t nodes, double seconds)
+{
+    auto nps = seconds > 0 ? static_cast<uint64_t>(nodes / seconds) : 0;
+    std::cout << "nodes " << nodes
+        << "  time " << std::fixed << std::setprecision(3) << seconds << "s"
+        << "  nps " << nps << "\n";
+}
+
+static double elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int runPosition(const PerftOptions& options)
+{
+    Board board(options.fen);
+    int depth = options.depth > 0 ? options.depth : 5;
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    if (options.divide) {
+        for (auto& [move, count] : divide(board, depth, options.bulk, options.filtered)) {
+            std::cout << move.toString() << ": " << count << "\n";
+            nodes += count;
+        }
+        std::cout << "\n";
+    }
+    else {
+        nodes = perft(board, depth, options.bulk, options.filtered);
+    }
+    std::cout << "depth " << depth << "  ";
+    report(nodes, elapsed(start));
+    return 0;
+}
+
+static int runSuite(const PerftOptions& options)
+{
+    auto suite = loadPerftSuite(options.epd);
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    auto suiteStart = std::chrono::steady_clock::now();
+
+    for (const auto& entry : suite) {
+        std::cout << entry.fen << "\n";
+        for (auto& [depth, expected] : entry.expected) {
+            if (options.depth > 0 && depth > options.depth)
+                continue;
+
+            Board board(entry.fen);
+            auto start = std::chrono::steady_clock::now();
+            auto nodes = perft(board, depth, options.bulk, options.filtered);
+            auto seconds = elapsed(start);
+            totalNodes += nodes;
+
+            bool ok = nodes == expected;
+            if (!ok)
+                ++failures;
+            std::cout << "  D" << depth << (ok ? " ok    " : " FAIL  ");
+            if (!ok)
+                std::cout << "expected " << expected << "  ";
+            report(nodes, seconds);
+        }
+    }
+
+    std::cout << "\ntotal  ";
+    report(totalNodes, elapsed(suiteStart));
+    if (failures)
+        std::cout << failures << " mismatch" << (failures == 1 ? "" : "es") << "\n";
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    PerftOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--fen" && hasValue) {
+            options.fen = argv[++i];
+        }
+        else if (arg == "--depth" && hasValue) {
+            options.depth = std::atoi(argv[++i]);
+        }
+        else if (arg == "--epd" && hasValue) {
+            options.epd = argv[++i];
+        }
+        else if (arg == "--divide") {
+            options.divide = true;
+        }
+        else if (arg == "--no-bulk") {
+            options.bulk = false;
+        }
+        else if (arg == "--filtered") {
+            options.filtered = true;
+        }
+        else {
+            usage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    try {
+        return options.epd.empty() ? runPosition(options) : runSuite(options);
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "perft: " << ex.what() << std::endl;
+        return 2;
+    }
+}
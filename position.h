@@ -0,0 +1,192 @@
+// position.h
+#pragma once
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "chesstypes.h"
+#include "square.h"
+#include "psqt.h"
+
+// Everything that describes a position and nothing about how it was reached.
+// It is trivially copyable so positions can be memcpy'd, handed to other
+// threads and stored in bulk; the undo history lives in Board.
+class Position {
+public:
+    bool operator==(const Position& other) const
+    {
+        return
+            turn == other.turn &&
+            enPassantTarget == other.enPassantTarget &&
+            halfMoveClock == other.halfMoveClock &&
+            fullMoveNumber == other.fullMoveNumber &&
+            whiteKingside == other.whiteKingside &&
+            whiteQueenside == other.whiteQueenside &&
+            blackKingside == other.blackKingside &&
+            blackQueenside == other.blackQueenside &&
+
+            white_pawns == other.white_pawns &&
+            white_knights == other.white_knights &&
+            white_bishops == other.white_bishops &&
+            white_rooks == other.white_rooks &&
+            white_queens == other.white_queens &&
+            white_kings == other.white_kings &&
+
+            black_pawns == other.black_pawns &&
+            black_knights == other.black_knights &&
+            black_bishops == other.black_bishops &&
+            black_rooks == other.black_rooks &&
+            black_queens == other.black_queens &&
+            black_kings == other.black_kings &&
+
+            whitePieces == other.whitePieces &&
+            blackPieces == other.blackPieces &&
+            allPieces == other.allPieces;
+    }
+    bool operator!=(const Position& other) const
+    {
+        return !(*this == other);
+    }
+
+    Piece pieceOn(int sq) const
+    {
+        uint8_t code = mailbox[sq];
+        return Piece{ static_cast<PieceType>(code & 7), (code & 8) ? Color::Black : Color::White };
+    }
+
+    // Puts a piece on a square, replacing whatever stood there; a piece of
+    // type None empties it. Keeps the bitboards and mailbox in step; the key
+    // and evaluation sums are left for the caller to recompute once the
+    // position is complete.
+    void putPiece(Piece piece, int sq)
+    {
+        uint64_t bit = 1ULL << sq;
+        Piece old = pieceOn(sq);
+        if (old.type != PieceType::None)
+            getPieceBB(old.type, old.color) &= ~bit;
+        if (piece.type != PieceType::None) {
+            getPieceBB(piece.type, piece.color) |= bit;
+            mailbox[sq] = pieceCode(piece.type, piece.color);
+        }
+        else {
+            mailbox[sq] = 0;
+        }
+
+        whitePieces = white_pawns | white_knights | white_bishops | white_rooks | white_queens | white_kings;
+        blackPieces = black_pawns | black_knights | black_bishops | black_rooks | black_queens | black_kings;
+        allPieces = whitePieces | blackPieces;
+    }
+
+    uint64_t pieces(PieceType type, Color color) const
+    {
+        return getPieceBB(type, color);
+    }
+
+    // Running key, updated by makeMove/undoMove
+    uint64_t zobristHash() const { return hashKey; }
+    // Running key of the pawns alone, for the pawn hash table
+    uint64_t pawnHash() const { return pawnKey; }
+    // Running evaluation sums for one color, updated by makeMove/undoMove
+    Score material(Color side) const { return materialScore[side == Color::White ? 0 : 1]; }
+    Score pieceSquares(Color side) const { return pstScore[side == Color::White ? 0 : 1]; }
+    int gamePhase() const { return phase; }
+
+    Color turn = Color::White;
+    Square enPassantTarget{ -1, -1 };
+    int halfMoveClock = 0;
+    int fullMoveNumber = 0;
+    bool whiteKingside = false;
+    bool whiteQueenside = false;
+    bool blackKingside = false;
+    bool blackQueenside = false;
+
+    uint64_t white_pawns = 0;
+    uint64_t white_knights = 0;
+    uint64_t white_bishops = 0;
+    uint64_t white_rooks = 0;
+    uint64_t white_queens = 0;
+    uint64_t white_kings = 0;
+
+    uint64_t black_pawns = 0;
+    uint64_t black_knights = 0;
+    uint64_t black_bishops = 0;
+    uint64_t black_rooks = 0;
+    uint64_t black_queens = 0;
+    uint64_t black_kings = 0;
+
+    uint64_t allPieces = 0;            // all pieces on the board
+    uint64_t whitePieces = 0;
+    uint64_t blackPieces = 0;
+
+protected:
+    static constexpr uint8_t pieceCode(PieceType type, Color color)
+    {
+        return static_cast<uint8_t>(type) | (color == Color::Black ? 8 : 0);
+    }
+
+    uint64_t& getPieceBB(PieceType type, Color color)
+    {
+        if (color == Color::White) {
+            switch (type) {
+                case PieceType::Pawn: return white_pawns;
+                case PieceType::Knight: return white_knights;
+                case PieceType::Bishop: return white_bishops;
+                case PieceType::Rook: return white_rooks;
+                case PieceType::Queen: return white_queens;
+                case PieceType::King: return white_kings;
+                default: throw std::runtime_error("Invalid piece type");
+            }
+        }
+        else {
+            switch (type) {
+                case PieceType::Pawn: return black_pawns;
+                case PieceType::Knight: return black_knights;
+                case PieceType::Bishop: return black_bishops;
+                case PieceType::Rook: return black_rooks;
+                case PieceType::Queen: return black_queens;
+                case PieceType::King: return black_kings;
+                default: throw std::runtime_error("Invalid piece type");
+            }
+        }
+    }
+
+    uint64_t getPieceBB(PieceType type, Color color) const
+    {
+        if (color == Color::White) {
+            switch (type) {
+                case PieceType::Pawn: return white_pawns;
+                case PieceType::Knight: return white_knights;
+                case PieceType::Bishop: return white_bishops;
+                case PieceType::Rook: return white_rooks;
+                case PieceType::Queen: return white_queens;
+                case PieceType::King: return white_kings;
+                default: throw std::runtime_error("Invalid piece type");
+            }
+        }
+        else {
+            switch (type) {
+                case PieceType::Pawn: return black_pawns;
+                case PieceType::Knight: return black_knights;
+                case PieceType::Bishop: return black_bishops;
+                case PieceType::Rook: return black_rooks;
+                case PieceType::Queen: return black_queens;
+                case PieceType::King: return black_kings;
+                default: throw std::runtime_error("Invalid piece type");
+            }
+        }
+    }
+
+    uint64_t hashKey = 0;
+    uint64_t pawnKey = 0;
+    // Piece on every square, PieceType in the low bits and 8 for black,
+    // kept in step with the bitboards for constant-time lookups.
+    std::array<uint8_t, 64> mailbox{};
+    std::array<Score, 2> materialScore{};
+    std::array<Score, 2> pstScore{};
+    int phase = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<Position>, "Position must stay memcpy-able");
+static_assert(sizeof(Position) <= 320, "Position should fit in five cache lines");
@@ -0,0 +1,156 @@
+// psqt.h
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "chesstypes.h"
+
+// Middlegame and endgame halves of an evaluation term
+struct Score {
+    int32_t mg = 0;
+    int32_t eg = 0;
+
+    constexpr Score& operator+=(Score other)
+    {
+        mg += other.mg;
+        eg += other.eg;
+        return *this;
+    }
+    constexpr Score& operator-=(Score other)
+    {
+        mg -= other.mg;
+        eg -= other.eg;
+        return *this;
+    }
+    constexpr Score operator+(Score other) const { return Score(*this) += other; }
+    constexpr Score operator-(Score other) const { return Score(*this) -= other; }
+    constexpr bool operator==(const Score& other) const { return mg == other.mg && eg == other.eg; }
+};
+
+// Phase runs from MAX_PHASE with all pieces on the board down to 0 with only
+// kings and pawns, and blends the middlegame and endgame scores.
+constexpr int MAX_PHASE = 24;
+constexpr std::array<int, 7> PHASE_WEIGHT = { 0, 0, 1, 1, 2, 4, 0 };  // by PieceType
+
+constexpr std::array<Score, 7> PIECE_SCORE = { {
+    { 0, 0 }, { 100, 100 }, { 320, 320 }, { 330, 330 }, { 500, 500 }, { 900, 900 }, { 20000, 20000 }
+} };
+
+namespace psqt_tables
+{
+    // White's point of view, rank 1 first
+    constexpr int pawnMg[64] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+          5,  10,  10, -20, -20,  10,  10,   5,
+          5,  -5, -10,   0,   0, -10,  -5,   5,
+          0,   0,   0,  20,  20,   0,   0,   0,
+          5,   5,  10,  25,  25,  10,   5,   5,
+         10,  10,  20,  30,  30,  20,  10,  10,
+         50,  50,  50,  50,  50,  50,  50,  50,
+          0,   0,   0,   0,   0,   0,   0,   0
+    };
+
+    constexpr int pawnEg[64] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+         10,  10,  10,  10,  10,  10,  10,  10,
+         10,  10,  10,  10,  10,  10,  10,  10,
+         20,  20,  20,  20,  20,  20,  20,  20,
+         30,  30,  30,  30,  30,  30,  30,  30,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         80,  80,  80,  80,  80,  80,  80,  80,
+          0,   0,   0,   0,   0,   0,   0,   0
+    };
+
+    constexpr int knight[64] = {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50
+    };
+
+    constexpr int bishop[64] = {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20
+    };
+
+    constexpr int rook[64] = {
+          0,   0,   0,   5,   5,   0,   0,   0,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+          5,  10,  10,  10,  10,  10,  10,   5,
+          0,   0,   0,   0,   0,   0,   0,   0
+    };
+
+    constexpr int queen[64] = {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20
+    };
+
+    constexpr int kingMg[64] = {
+         20,  30,  10,   0,   0,  10,  30,  20,
+         20,  20,   0,   0,   0,   0,  20,  20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30
+    };
+
+    constexpr int kingEg[64] = {
+        -50, -30, -30, -30, -30, -30, -30, -50,
+        -30, -30,   0,   0,   0,   0, -30, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -20, -10,   0,   0, -10, -20, -30,
+        -50, -40, -30, -20, -20, -30, -40, -50
+    };
+
+    // [color][piece type][square]; black squares are mirrored vertically
+    constexpr std::array<std::array<std::array<Score, 64>, 7>, 2> build()
+    {
+        std::array<std::array<std::array<Score, 64>, 7>, 2> table = {};
+        for (int sq = 0; sq < 64; ++sq) {
+            for (int c = 0; c < 2; ++c) {
+                int s = c == 0 ? sq : sq ^ 56;
+                auto& t = table[c];
+                t[static_cast<int>(PieceType::Pawn)][sq] = { pawnMg[s], pawnEg[s] };
+                t[static_cast<int>(PieceType::Knight)][sq] = { knight[s], knight[s] };
+                t[static_cast<int>(PieceType::Bishop)][sq] = { bishop[s], bishop[s] };
+                t[static_cast<int>(PieceType::Rook)][sq] = { rook[s], rook[s] };
+                t[static_cast<int>(PieceType::Queen)][sq] = { queen[s], queen[s] };
+                t[static_cast<int>(PieceType::King)][sq] = { kingMg[s], kingEg[s] };
+            }
+        }
+        return table;
+    }
+}
+
+constexpr auto PSQT = psqt_tables::build();
+
+inline Score pieceSquareScore(PieceType type, Color color, int sq)
+{
+    return PSQT[color == Color::White ? 0 : 1][static_cast<int>(type)][sq];
+}
@@ -0,0 +1,56 @@
+// timeman.cpp
+#include <algorithm>
+
+#include "timeman.h"
+
+void TimeManager::start(const SearchLimits& limits, Color side)
+{
+    startTime = std::chrono::steady_clock::now();
+    softLimit = 0;
+    hardLimit = 0;
+
+    if (limits.infinite)
+        return;
+
+    // A fixed move time is used in full
+    if (limits.movetime > 0) {
+        hardLimit = limits.movetime;
+        return;
+    }
+
+    int64_t time = (side == Color::White) ? limits.wtime : limits.btime;
+    int64_t inc = (side == Color::White) ? limits.winc : limits.binc;
+    if (time <= 0)
+        return;
+
+    // Spread the clock over the moves left, assuming 30 in sudden death
+    int movesToGo = limits.movestogo > 0 ? std::min(limits.movestogo, 50) : 30;
+    int64_t available = std::max<int64_t>(time - MOVE_OVERHEAD, 1);
+
+    softLimit = available / movesToGo + inc * 3 / 4;
+    hardLimit = std::min(softLimit * 4, available * 3 / 4);
+    hardLimit = std::max<int64_t>(hardLimit, 1);
+    softLimit = std::clamp<int64_t>(softLimit, 1, hardLimit);
+}
+
+int64_t TimeManager::elapsed() const
+{
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count();
+}
+
+bool TimeManager::softExpired(int stability) const
+{
+    if (softLimit <= 0)
+        return false;
+
+    // A best move that keeps changing gets more time, a settled one less
+    static const int percent[] = { 160, 120, 100, 80, 60 };
+    int64_t limit = softLimit * percent[std::min(stability, 4)] / 100;
+    return elapsed() >= std::min(limit, hardLimit);
+}
+
+bool TimeManager::hardExpired() const
+{
+    return hardLimit > 0 && elapsed() >= hardLimit;
+}
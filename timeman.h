@@ -0,0 +1,49 @@
+// timeman.h
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "chesstypes.h"
+
+// What the caller allows a search to spend. Zero means no limit of that kind;
+// times are in milliseconds.
+struct SearchLimits {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t movetime = 0;
+    int64_t wtime = 0;
+    int64_t btime = 0;
+    int64_t winc = 0;
+    int64_t binc = 0;
+    int movestogo = 0;
+    bool infinite = false;
+    // Searching on the opponent's time; the clock only applies after ponderhit
+    bool ponder = false;
+};
+
+// Turns the clock into two limits. The soft limit is checked between
+// iterations and stretches or shrinks with how settled the best move is;
+// the hard limit is polled inside the search and never exceeded.
+class TimeManager {
+public:
+    // Time kept back for communication and scheduling delays
+    static constexpr int64_t MOVE_OVERHEAD = 30;
+
+    void start(const SearchLimits& limits, Color side);
+
+    int64_t elapsed() const;
+    bool timed() const { return hardLimit > 0; }
+
+    // stability: consecutive completed iterations with the same best move
+    bool softExpired(int stability) const;
+    bool hardExpired() const;
+
+    int64_t soft() const { return softLimit; }
+    int64_t hard() const { return hardLimit; }
+
+private:
+    std::chrono::steady_clock::time_point startTime;
+    int64_t softLimit = 0;
+    int64_t hardLimit = 0;
+};
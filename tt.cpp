@@ -0,0 +1,140 @@
+// tt.cpp
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+#include "bitboard.h"
+#include "tt.h"
+
+// Data word layout:
+//   bits  0-15  move
+//   bits 16-47  score
+//   bits 48-55  depth
+//   bits 56-57  flag
+//   bits 58-63  generation
+uint64_t TranspositionTable::pack(PackedMove move, int32_t score, int depth, TTFlag flag, uint8_t generation)
+{
+    return uint64_t(move.data)
+        | (uint64_t(uint32_t(score)) << 16)
+        | (uint64_t(uint8_t(std::clamp(depth, 0, 255))) << 48)
+        | (uint64_t(flag) << 56)
+        | (uint64_t(generation & GENERATION_MASK) << 58);
+}
+
+TTEntry TranspositionTable::unpack(uint64_t data)
+{
+    TTEntry entry;
+    entry.move.data = static_cast<uint16_t>(data);
+    entry.score = static_cast<int32_t>(uint32_t(data >> 16));
+    entry.depth = static_cast<int>((data >> 48) & 0xff);
+    entry.flag = static_cast<TTFlag>((data >> 56) & 0x3);
+    entry.generation = static_cast<uint8_t>(data >> 58);
+    return entry;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t size = floorPow2(std::max<size_t>(megabytes, 1) * 1024 * 1024 / sizeof(Bucket));
+
+    table = std::make_unique<Bucket[]>(size);
+    count = size;
+    generation = 0;
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < count; ++i) {
+        for (auto& slot : table[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+    generation = (generation + 1) & GENERATION_MASK;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const
+{
+    for (auto& slot : bucketFor(key).slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data != 0) {
+            entry = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, PackedMove move, int32_t score, int depth, TTFlag flag)
+{
+    Bucket& bucket = bucketFor(key);
+
+    // Reuse the slot already holding this position, otherwise evict the one
+    // worth least: shallow entries first, and entries from earlier searches
+    // count as shallower the older they are.
+    Slot* replace = nullptr;
+    int worst = 0;
+    for (auto& slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == key) {
+            TTEntry old = unpack(data);
+            // Keep a deeper result from this search unless the new one is exact
+            if (old.generation == generation && old.depth > depth && flag != TTFlag::Exact)
+                return;
+            // A fail-low has no move of its own, so keep the previous one
+            if (move.isNull())
+                move = old.move;
+            replace = &slot;
+            break;
+        }
+
+        TTEntry old = unpack(data);
+        int age = (generation - old.generation) & GENERATION_MASK;
+        int value = old.depth - 8 * age;
+        if (!replace || value < worst) {
+            replace = &slot;
+            worst = value;
+        }
+    }
+
+    uint64_t data = pack(move, score, depth, flag, generation);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::prefetch(uint64_t key) const
+{
+#if defined(_MSC_VER)
+    _mm_prefetch(reinterpret_cast<const char*>(&bucketFor(key)), _MM_HINT_T0);
+#else
+    __builtin_prefetch(&bucketFor(key));
+#endif
+}
+
+int TranspositionTable::hashfull() const
+{
+    int used = 0;
+    size_t samples = std::min<size_t>(count, 1000 / BUCKET_SLOTS);
+    for (size_t i = 0; i < samples; ++i) {
+        for (auto& slot : table[i].slots) {
+            TTEntry entry = unpack(slot.data.load(std::memory_order_relaxed));
+            if (entry.flag != TTFlag::None && entry.generation == generation)
+                ++used;
+        }
+    }
+    return samples ? static_cast<int>(used * 1000 / (samples * BUCKET_SLOTS)) : 0;
+}
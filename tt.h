@@ -0,0 +1,77 @@
+// tt.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "chesstypes.h"
+#include "square.h"
+#include "move.h"
+
+enum class TTFlag : uint8_t { None, Exact, Lower, Upper };
+
+// What a probe hands back. Scores are stored as the search saw them; mate
+// distances are adjusted by the caller.
+struct TTEntry {
+    PackedMove move{};
+    int32_t score = 0;
+    int depth = 0;
+    TTFlag flag = TTFlag::None;
+    uint8_t generation = 0;
+};
+
+// Fixed-size hash table shared by all search threads without locks. Each
+// slot is two 64-bit words: the packed entry and the key XORed with it. A
+// slot torn by two threads writing at once fails the XOR check on the next
+// probe and is treated as a miss, so readers never see a mixed entry.
+class TranspositionTable {
+public:
+    static constexpr size_t DEFAULT_MB = 16;
+
+    explicit TranspositionTable(size_t megabytes = DEFAULT_MB);
+
+    // Reallocates the table, which also clears it. Not safe during a search.
+    void resize(size_t megabytes);
+    void clear();
+
+    // Starts a new search; older entries become preferred for replacement.
+    void newSearch();
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, PackedMove move, int32_t score, int depth, TTFlag flag);
+
+    // Pulls the bucket for a key into cache ahead of the probe.
+    void prefetch(uint64_t key) const;
+
+    size_t bucketCount() const { return count; }
+    uint8_t currentGeneration() const { return generation; }
+
+    // Permille of sampled slots written during the current search.
+    int hashfull() const;
+
+private:
+    static constexpr int BUCKET_SLOTS = 4;
+    static constexpr uint8_t GENERATION_MASK = 0x3f;
+
+    struct Slot {
+        std::atomic<uint64_t> check{ 0 };  // key ^ data
+        std::atomic<uint64_t> data{ 0 };
+    };
+
+    // One cache line per bucket
+    struct alignas(64) Bucket {
+        Slot slots[BUCKET_SLOTS];
+    };
+    static_assert(sizeof(Bucket) == 64, "TT bucket must fill one cache line");
+
+    static uint64_t pack(PackedMove move, int32_t score, int depth, TTFlag flag, uint8_t generation);
+    static TTEntry unpack(uint64_t data);
+
+    Bucket& bucketFor(uint64_t key) const { return table[key & (count - 1)]; }
+
+    std::unique_ptr<Bucket[]> table;
+    size_t count = 0;
+    uint8_t generation = 0;
+};
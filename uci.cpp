@@ -0,0 +1,300 @@
+// uci.cpp
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "tt.h"
+#include "uci.h"
+
+// Search selectivity, one option per SearchParams field
+struct CheckOption {
+    const char* name;
+    bool SearchParams::* field;
+};
+
+struct SpinOption {
+    const char* name;
+    int SearchParams::* field;
+    int min;
+    int max;
+};
+
+static const CheckOption checkOptions[] = {
+    { "NullMove", &SearchParams::nullMove },
+    { "LateMoveReductions", &SearchParams::lateMoveReductions },
+};
+
+static const SpinOption spinOptions[] = {
+    { "NullMinDepth", &SearchParams::nullMinDepth, 1, 32 },
+    { "NullReduction", &SearchParams::nullReduction, 1, 8 },
+    { "NullVerifyDepth", &SearchParams::nullVerifyDepth, 1, 64 },
+    { "LmrMinDepth", &SearchParams::lmrMinDepth, 2, 32 },
+    { "LmrFullMoves", &SearchParams::lmrFullMoves, 1, 64 },
+    { "LmrBase", &SearchParams::lmrBase, 0, 300 },
+    { "LmrDivisor", &SearchParams::lmrDivisor, 50, 1000 },
+};
+
+static std::string lowerCase(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+Uci::Uci(std::istream& in, std::ostream& out)
+    : in(in), out(out)
+{
+    engine.setInfoHandler([this](const SearchResult& result)
+        {
+            info(result);
+        });
+    board.loadFEN(START_FEN);
+}
+
+Uci::~Uci()
+{
+    engine.stop();
+    engine.waitForSearch();
+}
+
+void Uci::loop()
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!execute(line))
+            return;
+    }
+
+    // End of input counts as quit
+    execute("quit");
+}
+
+bool Uci::execute(const std::string& line)
+{
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command == "uci") {
+        uci();
+    }
+    else if (command == "isready") {
+        send("readyok");
+    }
+    else if (command == "setoption") {
+        engine.stop();
+        engine.waitForSearch();
+        setOption(args);
+    }
+    else if (command == "ucinewgame") {
+        engine.stop();
+        engine.waitForSearch();
+        engine.clearHash();
+    }
+    else if (command == "position") {
+        engine.stop();
+        engine.waitForSearch();
+        setPosition(args);
+    }
+    else if (command == "go") {
+        go(args);
+    }
+    else if (command == "stop") {
+        engine.stop();
+    }
+    else if (command == "ponderhit") {
+        engine.ponderhit();
+    }
+    else if (command == "quit") {
+        engine.stop();
+        engine.waitForSearch();
+        return false;
+    }
+    else if (!command.empty()) {
+        send("info string unknown command " + command);
+    }
+    return true;
+}
+
+void Uci::uci()
+{
+    send("id name chess");
+    send("id author Paul Baxter");
+    send("option name Hash type spin default " + std::to_string(TranspositionTable::DEFAULT_MB)
+        + " min 1 max " + std::to_string(MAX_HASH_MB));
+    send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+    send("option name Ponder type check default false");
+    send("option name EvalCache type spin default " + std::to_string(EvalCache::DEFAULT_KB / 1024)
+        + " min 1 max " + std::to_string(MAX_EVAL_CACHE_MB));
+
+    SearchParams defaults;
+    for (const auto& option : checkOptions)
+        send(std::string("option name ") + option.name + " type check default " + (defaults.*option.field ? "true" : "false"));
+    for (const auto& option : spinOptions)
+        send(std::string("option name ") + option.name + " type spin default " + std::to_string(defaults.*option.field)
+            + " min " + std::to_string(option.min) + " max " + std::to_string(option.max));
+    send("uciok");
+}
+
+// setoption name <id> [value <x>]; names may hold spaces
+void Uci::setOption(std::istringstream& args)
+{
+    std::string token, name, value;
+    args >> token;
+    while (args >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+    while (args >> token)
+        value += (value.empty() ? "" : " ") + token;
+
+    name = lowerCase(name);
+    try {
+        if (name == "hash") {
+            engine.setHashSize(std::clamp(std::stoi(value), 1, MAX_HASH_MB));
+            return;
+        }
+        if (name == "threads") {
+            engine.setThreads(std::clamp(std::stoi(value), 1, MAX_THREADS));
+            return;
+        }
+        if (name == "ponder")
+            return;
+        if (name == "evalcache") {
+            engine.setEvalCacheSize(size_t(std::clamp(std::stoi(value), 1, MAX_EVAL_CACHE_MB)) * 1024);
+            return;
+        }
+
+        SearchParams params = engine.params();
+        for (const auto& option : checkOptions) {
+            if (name == lowerCase(option.name)) {
+                params.*option.field = lowerCase(value) == "true";
+                engine.setParams(params);
+                return;
+            }
+        }
+        for (const auto& option : spinOptions) {
+            if (name == lowerCase(option.name)) {
+                params.*option.field = std::clamp(std::stoi(value), option.min, option.max);
+                engine.setParams(params);
+                return;
+            }
+        }
+        send("info string unknown option " + name);
+    }
+    catch (const std::exception&) {
+        send("info string bad value for " + name);
+    }
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+void Uci::setPosition(std::istringstream& args)
+{
+    std::string token, fen;
+    args >> token;
+    if (token == "startpos") {
+        fen = START_FEN;
+        args >> token;
+    }
+    else if (token == "fen") {
+        while (args >> token && token != "moves")
+            fen += token + " ";
+    }
+    else {
+        return;
+    }
+
+    try {
+        board.loadFEN(fen);
+    }
+    catch (const std::exception& e) {
+        send(std::string("info string bad fen: ") + e.what());
+        board.loadFEN(START_FEN);
+        return;
+    }
+
+    if (token != "moves")
+        return;
+    while (args >> token) {
+        PackedMove move = parseMove(board, token);
+        if (move.isNull()) {
+            send("info string illegal move " + token);
+            return;
+        }
+        board.makeMove(move);
+    }
+}
+
+void Uci::go(std::istringstream& args)
+{
+    SearchLimits limits;
+    std::string token;
+    while (args >> token) {
+        if (token == "infinite") limits.infinite = true;
+        else if (token == "ponder") limits.ponder = true;
+        else if (token == "depth") args >> limits.depth;
+        else if (token == "nodes") args >> limits.nodes;
+        else if (token == "movetime") args >> limits.movetime;
+        else if (token == "wtime") args >> limits.wtime;
+        else if (token == "btime") args >> limits.btime;
+        else if (token == "winc") args >> limits.winc;
+        else if (token == "binc") args >> limits.binc;
+        else if (token == "movestogo") args >> limits.movestogo;
+    }
+
+    engine.stop();
+    engine.waitForSearch();
+    engine.startSearch(board, limits, [this](const SearchResult& result)
+        {
+            bestMove(result);
+        });
+}
+
+void Uci::info(const SearchResult& result)
+{
+    uint64_t nps = result.time > 0 ? result.nodes * 1000 / result.time : 0;
+    std::ostringstream line;
+    line << "info depth " << result.depth
+        << " score " << formatScore(result.score)
+        << " nodes " << result.nodes
+        << " nps " << nps
+        << " time " << result.time
+        << " hashfull " << engine.hashfull()
+        << " pv";
+    for (auto move : result.pv)
+        line << ' ' << move.toUci();
+    send(line.str());
+}
+
+void Uci::bestMove(const SearchResult& result)
+{
+    std::string line = "bestmove " + (result.pv.empty() ? PackedMove{}.toUci() : result.pv[0].toUci());
+    if (result.pv.size() > 1)
+        line += " ponder " + result.pv[1].toUci();
+    send(line);
+}
+
+void Uci::send(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+    out << line << std::endl;
+}
+
+PackedMove Uci::parseMove(const Board& board, const std::string& text)
+{
+    MoveList moves;
+    board.generateFullyLegalMoves(board.getTurn(), moves);
+    for (auto move : moves) {
+        if (move.toUci() == text)
+            return move;
+    }
+    return PackedMove{};
+}
+
+// Centipawns, or moves to mate when a mate has been found
+std::string Uci::formatScore(int64_t score)
+{
+    if (std::abs(score) > Engine::MATE_BOUND) {
+        int64_t plies = Engine::MATE_SCORE - std::abs(score);
+        int64_t moves = (plies + 1) / 2;
+        return "mate " + std::to_string(score > 0 ? moves : -moves);
+    }
+    return "cp " + std::to_string(score);
+}
@@ -0,0 +1,53 @@
+// uci.h
+#pragma once
+#include <iosfwd>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "board.h"
+#include "engine.h"
+
+// Universal Chess Interface front end. Commands are read on the calling
+// thread while searches run on the engine's own search thread, so stop,
+// ponderhit and isready are answered while the engine thinks.
+class Uci {
+public:
+    static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    static constexpr int MAX_HASH_MB = 65536;
+    static constexpr int MAX_THREADS = 256;
+    static constexpr int MAX_EVAL_CACHE_MB = 1024;
+
+    Uci(std::istream& in, std::ostream& out);
+    ~Uci();
+
+    // Reads commands until quit or the end of the input
+    void loop();
+    // Runs one command line; false once the command was quit
+    bool execute(const std::string& line);
+
+    // Blocks until the running search, if any, has printed its bestmove
+    void waitForSearch() { engine.waitForSearch(); }
+
+    const Board& position() const { return board; }
+
+    // Finds the legal move written as e2e4 or e7e8q; the null move if none
+    static PackedMove parseMove(const Board& board, const std::string& text);
+    static std::string formatScore(int64_t score);
+
+private:
+    void uci();
+    void setOption(std::istringstream& args);
+    void setPosition(std::istringstream& args);
+    void go(std::istringstream& args);
+    void info(const SearchResult& result);
+    void bestMove(const SearchResult& result);
+    void send(const std::string& line);
+
+    std::istream& in;
+    std::ostream& out;
+    std::mutex outputMutex;   // info and bestmove come from the search thread
+
+    Engine engine;
+    Board board;
+};
@@ -0,0 +1,12 @@
+// ucimain.cpp
+#include <iostream>
+
+#include "uci.h"
+
+int main()
+{
+    std::ios::sync_with_stdio(false);
+    Uci uci(std::cin, std::cout);
+    uci.loop();
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Written by Paul Baxter
+#include <gtest/gtest.h>
+#include <random>
+#include <stdint.h>
+
+#include "attacks.h"
+#include "board.h"
+
+namespace attacks_unit_test
+{
+    TEST(attacks_unit_test, magic_matches_ray_walk)
+    {
+        std::mt19937_64 rng(12345);
+        for (int sq = 0; sq < 64; ++sq) {
+            for (int i = 0; i < 200; ++i) {
+                // Sparse and dense boards both matter for the blocker masks
+                uint64_t occupied = i & 1 ? rng() & rng() : rng() | rng();
+                EXPECT_EQ(rookAttacks(sq, occupied), slidingAttacks(sq, occupied, false));
+                EXPECT_EQ(bishopAttacks(sq, occupied), slidingAttacks(sq, occupied, true));
+                EXPECT_EQ(queenAttacks(sq, occupied),
+                    slidingAttacks(sq, occupied, false) | slidingAttacks(sq, occupied, true));
+            }
+        }
+    }
+
+    TEST(attacks_unit_test, empty_board_attacks)
+    {
+        // Rook on a1 sees the whole first rank and a-file
+        EXPECT_EQ(rookAttacks(0, 0), 0x01010101010101FEULL);
+        // Bishop on d4 sees both long diagonals through it
+        EXPECT_EQ(bishopAttacks(27, 0), 0x8041221400142241ULL);
+    }
+
+    TEST(attacks_unit_test, attackers_to_square)
+    {
+        Board board("4k3/8/8/3p4/4R3/8/5n2/4K3 w - - 0 1");
+
+        // Rook on e4 is hit by the d5 pawn and the f2 knight
+        EXPECT_EQ(board.attackersTo(28, board.allPieces), (1ULL << 35) | (1ULL << 13));
+        EXPECT_TRUE(board.isSquareAttacked(28, Color::Black));
+        EXPECT_FALSE(board.isSquareAttacked(28, Color::White));
+
+        // The rook checks along the open e-file, the knight misses e1
+        EXPECT_TRUE(board.isInCheck(Color::Black));
+        EXPECT_FALSE(board.isInCheck(Color::White));
+    }
+
+    TEST(attacks_unit_test, static_exchange)
+    {
+        // Undefended pawn
+        Board free("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1");
+        EXPECT_EQ(free.see(PackedMove(4, 36, PackedMove::Capture)), 100);
+
+        // Knight takes a pawn and is taken back: pawn for knight
+        Board defended("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1");
+        EXPECT_EQ(defended.see(PackedMove(19, 36, PackedMove::Capture)), 100 - 320);
+
+        // The second rook behind the first wins the pawn through the x-ray
+        Board xray("4r1k1/8/8/4p3/8/8/4R3/4R1K1 w - - 0 1");
+        EXPECT_EQ(xray.see(PackedMove(12, 36, PackedMove::Capture)), 100);
+
+        // The king may not recapture a defended piece
+        Board king("8/8/8/8/3k4/4r3/8/2B1R1K1 w - - 0 1");
+        EXPECT_EQ(king.see(PackedMove(4, 20, PackedMove::Capture)), 500);
+        EXPECT_EQ(king.leastValuableAttacker(20, Color::White), 2);
+        EXPECT_EQ(king.leastValuableAttacker(20, Color::Black), 27);
+        EXPECT_EQ(king.leastValuableAttacker(63, Color::Black), -1);
+
+        // Once the king takes, the rook behind it could take the king: the
+        // x-ray counts whichever piece left the line
+        Board behindKing("4k3/8/8/3n4/8/4N3/4K3/4r3 w - - 0 1");
+        EXPECT_EQ(behindKing.see(PackedMove(35, 20, PackedMove::Capture)), 320);
+
+        Board promotion("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1");
+        EXPECT_EQ(promotion.see(PackedMove(49, 57, PackedMove::promotionFlag(PieceType::Queen, false))), 800);
+    }
+}
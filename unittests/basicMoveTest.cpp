@@ -3,6 +3,7 @@
 #include <string>
 #include <stdint.h>
 #include <algorithm>
+#include <cstring>
 
 #include "fen.h"
 #include "board.h"
@@ -103,4 +104,101 @@ namespace move_unit_test
             }
         }
     }
-}
\ No newline at end of file
+
+    TEST(basicmove_unit_test, packed_move_round_trip)
+    {
+        const Move moves[] =
+        {
+            Move({ 4, 1 }, { 4, 3 }),
+            Move({ 3, 3 }, { 4, 4 }, MoveType::Capture),
+            Move({ 4, 4 }, { 3, 5 }, MoveType::EnPassant),
+            Move({ 4, 0 }, { 6, 0 }, MoveType::Castle),
+            Move({ 4, 7 }, { 2, 7 }, MoveType::Castle),
+            Move({ 0, 6 }, { 0, 7 }, MoveType::Promotion, PieceType::Knight),
+            Move({ 7, 1 }, { 7, 0 }, MoveType::Promotion, PieceType::Queen),
+            Move({ 6, 1 }, { 6, 3 }, MoveType::DoublePush),
+            Move({ 1, 6 }, { 0, 7 }, MoveType::PromotionCapture, PieceType::Rook),
+        };
+
+        for (const auto& move : moves) {
+            PackedMove packed(move);
+            Move back(packed);
+            EXPECT_EQ(packed.from(), move.from.y * 8 + move.from.x);
+            EXPECT_EQ(packed.to(), move.to.y * 8 + move.to.x);
+            EXPECT_TRUE(back.from == move.from && back.to == move.to);
+            EXPECT_EQ(back.type, move.type);
+            EXPECT_EQ(back.promotionType, move.promotionType);
+        }
+
+        PackedMove promo(52, 61, PackedMove::promotionFlag(PieceType::Rook, true));
+        EXPECT_TRUE(promo.isPromotion());
+        EXPECT_TRUE(promo.isCapture());
+        EXPECT_EQ(promo.promotionType(), PieceType::Rook);
+        EXPECT_EQ(sizeof(PackedMove), 2u);
+
+        // Every generated flag survives the trip through Move, capturing
+        // promotions and double pushes included
+        Board board("r3k2r/pP4P1/8/3pP3/8/8/1p4pP/R3K2R w KQkq d6 0 1");
+        for (auto side : { Color::White, Color::Black }) {
+            board.turn = side;
+            MoveList generated;
+            board.generateFullyLegalMoves(side, generated);
+            int promotionCaptures = 0, doublePushes = 0;
+            for (auto packed : generated) {
+                EXPECT_EQ(PackedMove(Move(packed)), packed) << packed.toString();
+                promotionCaptures += packed.isPromotion() && packed.isCapture();
+                doublePushes += packed.flags() == PackedMove::DoublePush;
+            }
+            EXPECT_GT(promotionCaptures, 0);
+            EXPECT_GT(doublePushes, 0);
+        }
+        EXPECT_EQ(Move(PackedMove(12, 28, PackedMove::DoublePush)).type, MoveType::DoublePush);
+        EXPECT_TRUE(PackedMove(Move({ 1, 6 }, { 0, 7 }, MoveType::PromotionCapture, PieceType::Rook)).isCapture());
+    }
+
+    TEST(basicmove_unit_test, mailbox_follows_moves)
+    {
+        Board board("r3k2r/8/8/3pP3/8/8/8/R3K2R w KQkq d6 0 1");
+
+        // Castling moves the rook square too
+        board.makeMove(PackedMove(4, 6, PackedMove::KingCastle));
+        EXPECT_EQ(board.pieceOn(6).type, PieceType::King);
+        EXPECT_EQ(board.pieceOn(5).type, PieceType::Rook);
+        EXPECT_EQ(board.pieceOn(7).type, PieceType::None);
+        EXPECT_EQ(board.pieceOn(4).type, PieceType::None);
+        board.undoMove();
+        EXPECT_EQ(board.pieceOn(4).type, PieceType::King);
+        EXPECT_EQ(board.pieceOn(7).type, PieceType::Rook);
+        EXPECT_EQ(board.pieceOn(5).type, PieceType::None);
+
+        // En passant empties the captured pawn's square
+        board.makeMove(PackedMove(36, 43, PackedMove::EnPassant));
+        EXPECT_EQ(board.pieceOn(35).type, PieceType::None);
+        EXPECT_EQ(board.pieceOn(43).type, PieceType::Pawn);
+        EXPECT_EQ(board.pieceOn(43).color, Color::White);
+        board.undoMove();
+        EXPECT_EQ(board.pieceOn(35).type, PieceType::Pawn);
+        EXPECT_EQ(board.pieceOn(35).color, Color::Black);
+        EXPECT_EQ(board.pieceOn(43).type, PieceType::None);
+    }
+
+    TEST(basicmove_unit_test, position_copies_bytewise)
+    {
+        Board board("r3k2r/8/8/3pP3/8/8/8/R3K2R w KQkq d6 0 1");
+        board.makeMove(PackedMove(4, 6, PackedMove::KingCastle));
+
+        Position copy;
+        std::memcpy(static_cast<void*>(&copy), &board.position(), sizeof(Position));
+        EXPECT_TRUE(copy == board.position());
+        EXPECT_EQ(copy.zobristHash(), board.zobristHash());
+
+        // A board started from the copy plays on without the old history
+        Board other(copy);
+        MoveList moves;
+        other.generateFullyLegalMoves(other.getTurn(), moves);
+        ASSERT_FALSE(moves.empty());
+        other.makeMove(moves[0]);
+        other.undoMove();
+        EXPECT_TRUE(other == board);
+    }
+}
@@ -8,6 +8,7 @@
 #include "board.h"
 #include "bitboard.h"
 #include "engine.h"
+#include "pawns.h"
 #include "chess.h"
 #include "utils.h"
 #include "chesstypes.h"
@@ -54,34 +55,99 @@ namespace engine_unit_test
 
     TEST(evalute_unit_test, evaluate_single)
     {
+        // A lone piece scores the same for either color once the board is
+        // mirrored. Its material dominates; placement, mobility and, for a
+        // pawn, passed bonuses add at most two pawns either way.
         Fen f;
         Engine e;
         for (auto piece : pieces) {
             for (auto x = 0; x < 8; ++x) {
                 for (auto y = 0; y < 8; ++y) {
-                    for (auto color : { Color::White, Color::Black }) {
-                        f.clear();
-                        f.turn = color;
-                        f.placePiece({ piece, color }, x, y);
-                        Board b(f.toString());
-
-                        auto expectedScore = pieceValues[(int)piece];
-                        if (piece == PieceType::Pawn || piece == PieceType::Knight) {
-
-                            for (auto square : centerSquares) {
-                                if (x == square[0] && y == square[1]) {
-                                    expectedScore += 200;
-                                    break;
-                                }
-                            }
-                        }
-
-                        auto score = e.evaluate(b);
-                        EXPECT_EQ(score, expectedScore);
+                    f.clear();
+                    f.turn = Color::White;
+                    f.placePiece({ piece, Color::White }, x, y);
+                    Board white(f.toString());
+
+                    f.clear();
+                    f.turn = Color::Black;
+                    f.placePiece({ piece, Color::Black }, x, 7 - y);
+                    Board black(f.toString());
+
+                    auto score = e.evaluate(white);
+                    EXPECT_EQ(e.evaluate(black), score);
+
+                    // The side not to move sees the same score negated
+                    white.turn = Color::Black;
+                    EXPECT_EQ(e.evaluate(white), -score);
+
+                    if (piece == PieceType::None)
+                        EXPECT_EQ(score, 0);
+                    else if (piece != PieceType::King) {
+                        EXPECT_GT(score, pieceValues[(int)piece] / 2);
+                        EXPECT_LT(score, pieceValues[(int)piece] + 200);
                     }
                 }
             }
-
         }
     }
-}
\ No newline at end of file
+
+    TEST(evalute_unit_test, incremental_scores)
+    {
+        // Black captures the h1 rook and promotes
+        Board b("rnbqkbnr/ppp1ppp1/8/3p4/4P3/8/PPPP1PpP/RNBQKBNR b KQkq - 0 1");
+        auto white = b.material(Color::White);
+        auto black = b.material(Color::Black);
+        auto phase = b.gamePhase();
+
+        b.makeMove(PackedMove(14, 7, PackedMove::promotionFlag(PieceType::Queen, true)));
+        EXPECT_EQ(b.material(Color::White).mg, white.mg - pieceValues[(int)PieceType::Rook]);
+        EXPECT_EQ(b.material(Color::Black).mg, black.mg - pieceValues[(int)PieceType::Pawn] + pieceValues[(int)PieceType::Queen]);
+        EXPECT_EQ(b.gamePhase(), phase - 2 + 4);
+
+        b.undoMove();
+        EXPECT_TRUE(b.material(Color::White) == white);
+        EXPECT_TRUE(b.material(Color::Black) == black);
+        EXPECT_EQ(b.gamePhase(), phase);
+
+        // Piece-square sums are mirror images in a symmetric position
+        Board start("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        EXPECT_TRUE(start.pieceSquares(Color::White) == start.pieceSquares(Color::Black));
+        EXPECT_EQ(start.gamePhase(), 24);
+    }
+
+    TEST(evalute_unit_test, pawn_structure)
+    {
+        // Black has only the doubled a-pawns, so every pawn on the board is passed
+        Board b("4k3/p7/p7/3P4/8/8/5PPP/4K3 w - - 0 1");
+        PawnEntry entry;
+        evaluatePawns(b, entry);
+        EXPECT_EQ(entry.key, b.pawnHash());
+        EXPECT_EQ(entry.passed[0], (1ULL << 35) | (7ULL << 13));
+        EXPECT_EQ(entry.passed[1], (1ULL << 48) | (1ULL << 40));
+        // f2 g2 h2 shield a king on g1, a king on a1 has an open file beside it
+        EXPECT_GT(entry.kingShelter(Color::White, 6), entry.kingShelter(Color::White, 0));
+        EXPECT_EQ(entry.kingShelter(Color::White, 6 + 8 * 3), 0);
+        // countr_zero of a missing king
+        EXPECT_EQ(entry.kingShelter(Color::Black, 64), 0);
+        EXPECT_EQ(entry.kingShelter(Color::White, 64), 0);
+    }
+
+    TEST(evalute_unit_test, pawn_hash_hits)
+    {
+        Board b("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        PawnHashTable table(1024);
+        const PawnEntry& first = table.probe(b);
+        EXPECT_EQ(table.hits(), 0u);
+
+        // A knight move leaves the pawn key, and so the entry, unchanged
+        b.makeMove(PackedMove(36, 30));   // Ng4
+        const PawnEntry& second = table.probe(b);
+        EXPECT_EQ(&first, &second);
+        EXPECT_EQ(table.hits(), 1u);
+        EXPECT_EQ(table.probes(), 2u);
+
+        PawnEntry fresh;
+        evaluatePawns(b, fresh);
+        EXPECT_TRUE(second.score == fresh.score);
+    }
+}
@@ -3,6 +3,9 @@
 #include <string>
 #include <stdint.h>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include "fen.h"
 #include "board.h"
@@ -221,4 +224,69 @@ namespace move_unit_test
             expected_black_kings
         );
     }
-}
\ No newline at end of file
+
+    TEST(fen_unit_test, round_trip)
+    {
+        const char* fens[] = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+            "4k3/8/8/8/8/8/8/4K2R b K - 17 42",
+        };
+        for (auto fen : fens) {
+            Board board(fen);
+            char buffer[MAX_FEN_LENGTH];
+            size_t length = writeFen(board, buffer);
+            EXPECT_EQ(std::string_view(buffer, length), fen);
+            EXPECT_EQ(toFen(Fen(fen)), fen);
+        }
+
+        // Counters may be left off
+        Board board("8/8/8/8/8/8/8/K6k b - -");
+        EXPECT_EQ(toFen(board), "8/8/8/8/8/8/8/K6k b - - 0 1");
+
+        EXPECT_THROW(Board("8/8/8/8/8/8/8/K6x w - - 0 1"), std::runtime_error);
+        EXPECT_THROW(Board("8/8/8/8/8/8/8/K6k x - - 0 1"), std::runtime_error);
+        EXPECT_THROW(Board("8/8/8/8/8/8/8/K6k w - z9 0 1"), std::runtime_error);
+    }
+
+    TEST(fen_unit_test, place_none_clears_square)
+    {
+        Fen f("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+        f.placePiece({ PieceType::None, Color::White }, 0, 0);
+        EXPECT_EQ(f.pieceOn(0).type, PieceType::None);
+        EXPECT_EQ(f.white_rooks, 0u);
+        EXPECT_EQ(f.whitePieces, f.white_kings);
+        EXPECT_EQ(f.allPieces, f.white_kings | f.black_kings);
+        EXPECT_EQ(f.toString(), "4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+
+        // An empty square stays empty
+        f.placePiece({ PieceType::None, Color::Black }, 3, 3);
+        EXPECT_EQ(f.pieceOn(27).type, PieceType::None);
+    }
+
+    TEST(fen_unit_test, parses_on_many_threads)
+    {
+        const std::string kiwipete = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+        const std::string endgame = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1";
+        const Board expected[] = { Board(kiwipete), Board(endgame) };
+
+        std::atomic<int> mismatches{ 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t]()
+                {
+                    for (int i = 0; i < 500; ++i) {
+                        int which = (t + i) & 1;
+                        Board board(which ? endgame : kiwipete);
+                        if (board != expected[which] || board.zobristHash() != expected[which].zobristHash())
+                            ++mismatches;
+                    }
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        EXPECT_EQ(mismatches.load(), 0);
+    }
+}
@@ -155,16 +155,11 @@ namespace move_unit_test
                 std::string fullFen = fenBoard + fenSuffix;
 
                 expectedMoves.clear();
-                Move captureMove;
-                captureMove.from = { x, y };
-                captureMove.to = { x - 1, y + 1 };
-                expectedMoves.push_back(captureMove);
-
+                AddPawnMove(expectedMoves, { x, y }, { x - 1, y + 1 });
 
                 Move normalMove;
                 normalMove.from = { x, y };
-                normalMove.to = { x, y + 1 };
-                expectedMoves.push_back(normalMove);
+                AddPawnMove(expectedMoves, { x, y }, { x, y + 1 });
                 if (y == 1) {
                     normalMove.to = { x, y + 2 };
                     expectedMoves.push_back(normalMove);
@@ -209,10 +204,10 @@ namespace move_unit_test
                 expectedMoves.clear();
 
                 // Capture right
-                expectedMoves.push_back(Move{ Square{x, y}, Square{x + 1, y - 1} });
+                AddPawnMove(expectedMoves, Square{ x, y }, Square{ x + 1, y - 1 });
 
                 // Forward move (if not blocked)
-                expectedMoves.push_back(Move{ Square{x, y}, Square{x, y - 1} });
+                AddPawnMove(expectedMoves, Square{ x, y }, Square{ x, y - 1 });
 
                 // Double move if on rank 7
                 if (y == 6)
@@ -259,7 +254,7 @@ namespace move_unit_test
                 if (startfile < '8') {
                     expectedMove.from = locationToSquare(std::string() + startrank + startfile);
                     expectedMove.to = locationToSquare(std::string() + startrank + (char)(startfile + 1));
-                    expectedMoves.push_back(expectedMove);
+                    AddPawnMove(expectedMoves, expectedMove.from, expectedMove.to);
 
                     if (startfile == '2') {
                         expectedMove.to = locationToSquare(std::string() + startrank + (char)(startfile + 2));
@@ -0,0 +1,183 @@
+// Written by Paul Baxter
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "board.h"
+#include "perft.h"
+
+namespace perft_unit_test
+{
+    // Published counts, kept shallow so the suite stays fast.
+    static const char* positions[] =
+    {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400 ;D3 8902",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ;D1 48 ;D2 2039 ;D3 97862",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ;D1 14 ;D2 191 ;D3 2812 ;D4 43238",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1 ;D1 6 ;D2 264 ;D3 9467",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 ;D1 44 ;D2 1486 ;D3 62379",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10 ;D1 46 ;D2 2079",
+        "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1 ;D4 13931",
+        "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1 ;D4 19174",
+    };
+
+    TEST(perft_unit_test, perft_suite)
+    {
+        for (auto line : positions) {
+            PerftEntry entry;
+            ASSERT_TRUE(parsePerftEntry(line, entry));
+
+            for (auto& [depth, expected] : entry.expected) {
+                Board board(entry.fen);
+                EXPECT_EQ(perft(board, depth), expected) << entry.fen << " depth " << depth;
+            }
+        }
+    }
+
+    TEST(perft_unit_test, legal_matches_filtered)
+    {
+        for (auto line : positions) {
+            PerftEntry entry;
+            ASSERT_TRUE(parsePerftEntry(line, entry));
+
+            Board board(entry.fen);
+            EXPECT_EQ(perft(board, 3), perft(board, 3, true, true)) << entry.fen;
+        }
+    }
+
+    TEST(perft_unit_test, legal_edge_cases)
+    {
+        // En passant would expose the king along the fifth rank
+        Board ep("8/8/8/K2pP2r/8/8/8/7k w - d6 0 1");
+        MoveList moves;
+        ep.generateFullyLegalMoves(Color::White, moves);
+        for (const auto& m : moves)
+            EXPECT_FALSE(m.isEnPassant());
+
+        // Castling through the attacked f1 square is not allowed
+        Board castle("4k3/8/8/8/8/8/5r2/R3K2R w KQ - 0 1");
+        moves.clear();
+        castle.generateFullyLegalMoves(Color::White, moves);
+        for (const auto& m : moves)
+            EXPECT_NE(m.flags(), PackedMove::KingCastle);
+    }
+
+    // Walks two plies deep comparing the captures-only generator against the
+    // captures and promotions picked out of the full legal list
+    static void compareCaptures(Board& board, int depth)
+    {
+        MoveList all, captures, expected;
+        board.generateFullyLegalMoves(board.getTurn(), all);
+        board.generateLegalCaptures(board.getTurn(), captures);
+        for (const auto& m : all) {
+            if (m.isCapture() || m.isPromotion())
+                expected.push_back(m);
+        }
+
+        std::vector<uint16_t> a, b;
+        for (const auto& m : captures) a.push_back(m.data);
+        for (const auto& m : expected) b.push_back(m.data);
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        EXPECT_EQ(a, b) << board.toString();
+
+        if (depth == 0)
+            return;
+        for (const auto& m : all) {
+            board.makeMove(m);
+            compareCaptures(board, depth - 1);
+            board.undoMove();
+        }
+    }
+
+    TEST(perft_unit_test, legal_captures_subset)
+    {
+        for (auto line : positions) {
+            PerftEntry entry;
+            ASSERT_TRUE(parsePerftEntry(line, entry));
+
+            Board board(entry.fen);
+            compareCaptures(board, 2);
+        }
+    }
+
+    // Every 16-bit move is accepted by isPseudoLegal and isLegal exactly when
+    // the legal generator produces it, and quiets and captures split the list
+    static void compareMoveChecks(Board& board, int depth)
+    {
+        MoveList all, captures, quiets;
+        board.generateFullyLegalMoves(board.getTurn(), all);
+        board.generateLegalCaptures(board.getTurn(), captures);
+        board.generateLegalQuiets(board.getTurn(), quiets);
+        EXPECT_EQ(captures.size() + quiets.size(), all.size()) << board.toString();
+
+        std::vector<bool> legal(1 << 16);
+        for (const auto& m : all)
+            legal[m.data] = true;
+        for (const auto& m : quiets)
+            EXPECT_TRUE(legal[m.data] && !m.isCapture() && !m.isPromotion());
+        for (int data = 0; data < (1 << 16); ++data) {
+            PackedMove move;
+            move.data = static_cast<uint16_t>(data);
+            bool accepted = board.isPseudoLegal(move) && board.isLegal(move);
+            EXPECT_EQ(accepted, legal[data]) << board.toString() << move.toString();
+        }
+
+        if (depth == 0)
+            return;
+        for (const auto& m : all) {
+            board.makeMove(m);
+            compareMoveChecks(board, depth - 1);
+            board.undoMove();
+        }
+    }
+
+    TEST(perft_unit_test, pseudo_legal_check)
+    {
+        for (auto line : positions) {
+            PerftEntry entry;
+            ASSERT_TRUE(parsePerftEntry(line, entry));
+
+            Board board(entry.fen);
+            compareMoveChecks(board, 1);
+        }
+    }
+
+    TEST(perft_unit_test, bulk_matches_full)
+    {
+        Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        EXPECT_EQ(perft(board, 2, true), perft(board, 2, false));
+    }
+
+    TEST(perft_unit_test, divide_sums_to_perft)
+    {
+        Board board("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+        uint64_t total = 0;
+        for (auto& [move, nodes] : divide(board, 3))
+            total += nodes;
+        EXPECT_EQ(total, 9467u);
+    }
+
+    TEST(perft_unit_test, undo_restores_position)
+    {
+        Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        Board before = board;
+        perft(board, 3);
+        EXPECT_TRUE(board == before);
+    }
+
+    TEST(perft_unit_test, parse_epd_line)
+    {
+        PerftEntry entry;
+        EXPECT_FALSE(parsePerftEntry("# comment", entry));
+        EXPECT_FALSE(parsePerftEntry("   ", entry));
+
+        ASSERT_TRUE(parsePerftEntry("8/8/8/8/8/8/8/K1k5 w - - 0 1 ;D1 3 ;D2 15\r", entry));
+        EXPECT_EQ(entry.fen, "8/8/8/8/8/8/8/K1k5 w - - 0 1");
+        ASSERT_EQ(entry.expected.size(), 2u);
+        EXPECT_EQ(entry.expected[0], std::make_pair(1, uint64_t(3)));
+        EXPECT_EQ(entry.expected[1], std::make_pair(2, uint64_t(15)));
+    }
+}
@@ -0,0 +1,270 @@
+// Written by Paul Baxter
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "engine.h"
+#include "tt.h"
+
+namespace search_unit_test
+{
+    // Plays a principal variation out, each move checked to be legal
+    static void expectLegalLine(Board board, const std::vector<PackedMove>& pv)
+    {
+        ASSERT_FALSE(pv.empty());
+        for (auto move : pv) {
+            MoveList legal;
+            board.generateFullyLegalMoves(board.getTurn(), legal);
+            ASSERT_NE(std::find(legal.begin(), legal.end(), move), legal.end()) << move.toUci();
+            board.makeMove(move);
+        }
+    }
+
+    TEST(search_unit_test, finds_mate_in_one)
+    {
+        for (int threads : { 1, 4 }) {
+            Board board("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+            Engine engine;
+            engine.setThreads(threads);
+
+            std::vector<Move> moves;
+            auto best = engine.findBestMove(board, 3, moves);
+            EXPECT_EQ(best.toString(), "a1-a8") << threads << " threads";
+            EXPECT_GT(best.score, Engine::MATE_BOUND);
+        }
+    }
+
+    TEST(search_unit_test, quiescence_sees_recapture)
+    {
+        // Qxd5 wins a pawn at depth 1 unless the recapture is searched
+        Board board("4k3/8/4p3/3p4/8/8/8/3QK3 w - - 0 1");
+        Engine engine;
+        std::vector<Move> moves;
+        auto best = engine.findBestMove(board, 1, moves);
+        EXPECT_NE(best.toString(), "d1xd5");
+    }
+
+    TEST(search_unit_test, no_legal_moves)
+    {
+        Board board("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+        Engine engine;
+        std::vector<Move> moves;
+        auto best = engine.findBestMove(board, 2, moves);
+        EXPECT_TRUE(best.from == best.to);
+        EXPECT_TRUE(moves.empty());
+    }
+
+    TEST(search_unit_test, principal_variation_is_legal)
+    {
+        Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        Engine engine;
+        std::vector<Move> moves;
+        std::vector<PackedMove> pv;
+        auto best = engine.findBestMove(board, 5, moves, pv);
+
+        ASSERT_GE(pv.size(), 2u);
+        EXPECT_EQ(Move(pv[0]).toString(), best.toString());
+        for (auto move : pv) {
+            MoveList legal;
+            board.generateFullyLegalMoves(board.getTurn(), legal);
+            ASSERT_NE(std::find(legal.begin(), legal.end(), move), legal.end()) << move.toUci();
+            board.makeMove(move);
+        }
+    }
+
+    TEST(search_unit_test, selectivity_saves_nodes)
+    {
+        Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        SearchLimits limits;
+        limits.depth = 6;
+
+        Engine selective;
+        auto pruned = selective.search(board, limits);
+
+        Engine full;
+        SearchParams params;
+        params.nullMove = false;
+        params.lateMoveReductions = false;
+        full.setParams(params);
+        auto unpruned = full.search(board, limits);
+
+        EXPECT_LT(pruned.nodes, unpruned.nodes);
+        EXPECT_FALSE(pruned.bestMove.from == pruned.bestMove.to);
+    }
+
+    TEST(search_unit_test, eval_cache_hits)
+    {
+        Board board("r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8");
+        Engine engine;
+        engine.setEvalCacheSize(256);
+        SearchLimits limits;
+        limits.depth = 5;
+        engine.search(board, limits);
+
+        EXPECT_GT(engine.evalCacheHits(), 0u);
+        EXPECT_LE(engine.evalCacheHits(), engine.evalCacheProbes());
+        EXPECT_LE(engine.pawnHits(), engine.pawnProbes());
+    }
+
+    TEST(search_unit_test, engines_keep_own_hash)
+    {
+        Board board("r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8");
+        Engine searched;
+        Engine other;
+        SearchLimits limits;
+        limits.depth = 6;
+        searched.search(board, limits);
+        int used = searched.hashfull();
+        EXPECT_GT(used, 0);
+        EXPECT_EQ(other.hashfull(), 0);
+
+        // Clearing or resizing one engine's table leaves the other's alone
+        other.clearHash();
+        other.setHashSize(1);
+        EXPECT_EQ(searched.hashfull(), used);
+        searched.clearHash();
+        EXPECT_EQ(searched.hashfull(), 0);
+    }
+
+    TEST(search_unit_test, repetition_ends_principal_variation)
+    {
+        // Rxa2 looks best at depth 1 but runs into Rd8 mate; a queen down,
+        // Black's best is then to repeat with Nd6, which also shuts the
+        // d-file. The Rd8 found for Rxa2 must not be left behind it.
+        Board board("r6k/6pp/3n4/8/8/8/Q4PPP/3R2K1 w - - 0 1");
+        board.makeMove(PackedMove(6, 5));     // Kf1
+        board.makeMove(PackedMove(43, 33));   // Nb5
+        board.makeMove(PackedMove(5, 6));     // Kg1
+
+        Engine engine;
+        std::vector<Move> moves;
+        std::vector<PackedMove> pv;
+        auto best = engine.findBestMove(board, 4, moves, pv);
+        EXPECT_EQ(best.toString(), Move(PackedMove(33, 43)).toString());
+        EXPECT_EQ(best.score, 0);
+
+        expectLegalLine(board, pv);
+    }
+
+    TEST(search_unit_test, fifty_move_principal_variation)
+    {
+        // Most replies end the game drawn; the lines searched before them
+        // must not be copied in behind them
+        Board board("8/K1pr4/3p4/1P5k/5p2/8/1R2P1P1/8 w - - 98 4");
+        Engine engine;
+        std::vector<Move> moves;
+        std::vector<PackedMove> pv;
+        engine.findBestMove(board, 4, moves, pv);
+        expectLegalLine(board, pv);
+    }
+
+    TEST(search_unit_test, fifty_move_mate)
+    {
+        // The back-rank mate is the hundredth reversible ply; mate outranks
+        // the fifty-move rule, a quiet move does not
+        Board board("6k1/5ppp/8/8/8/8/8/R5K1 w - - 99 80");
+        board.makeMove(PackedMove(0, 56));   // Ra8#
+        EXPECT_FALSE(board.isDraw());
+        board.undoMove();
+        board.makeMove(PackedMove(0, 8));    // Ra2
+        EXPECT_TRUE(board.isDraw());
+        board.undoMove();
+
+        Engine engine;
+        SearchLimits limits;
+        limits.depth = 3;
+        auto result = engine.search(board, limits);
+        ASSERT_FALSE(result.pv.empty());
+        EXPECT_EQ(result.pv[0], PackedMove(0, 56));
+        EXPECT_EQ(result.score, Engine::MATE_SCORE - 1);
+    }
+
+    TEST(search_unit_test, fifty_move_draw)
+    {
+        // A queen up, but any move that is not mate ends the game drawn
+        Board board("7k/8/8/8/8/8/8/KQ6 w - - 99 80");
+        Engine engine;
+        SearchLimits limits;
+        limits.depth = 4;
+        auto result = engine.search(board, limits);
+        EXPECT_EQ(result.score, 0);
+
+        board.loadFEN("7k/8/8/8/8/8/8/KQ6 w - - 0 80");
+        result = engine.search(board, limits);
+        EXPECT_GT(result.score, 500);
+    }
+
+    TEST(search_unit_test, threads_restart)
+    {
+        Engine engine;
+        engine.setThreads(3);
+        EXPECT_EQ(engine.threadCount(), 3);
+        engine.setThreads(0);
+        EXPECT_EQ(engine.threadCount(), 1);
+    }
+
+    TEST(search_unit_test, node_limit)
+    {
+        Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        Engine engine;
+        SearchLimits limits;
+        limits.nodes = 5000;
+
+        auto result = engine.search(board, limits);
+        EXPECT_FALSE(result.bestMove.from == result.bestMove.to);
+        // Limits are polled every 1024 nodes
+        EXPECT_LT(result.nodes, limits.nodes + 1024);
+    }
+
+    TEST(search_unit_test, stop_infinite_search)
+    {
+        Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        Engine engine;
+        SearchLimits limits;
+        limits.infinite = true;
+
+        std::thread stopper([&]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                engine.stop();
+            });
+        auto result = engine.search(board, limits);
+        stopper.join();
+
+        EXPECT_GE(result.depth, 1);
+        EXPECT_FALSE(result.bestMove.from == result.bestMove.to);
+    }
+
+    TEST(search_unit_test, clock_allocation)
+    {
+        SearchLimits limits;
+        TimeManager timer;
+
+        limits.movetime = 250;
+        timer.start(limits, Color::White);
+        EXPECT_EQ(timer.hard(), 250);
+
+        // Sudden death: a slice of the clock, the hard limit well short of flagging
+        limits = SearchLimits();
+        limits.wtime = 60000;
+        limits.winc = 1000;
+        limits.btime = 1000;
+        timer.start(limits, Color::White);
+        EXPECT_GT(timer.soft(), 1000);
+        EXPECT_LT(timer.soft(), timer.hard());
+        EXPECT_LT(timer.hard(), 60000 / 2);
+
+        // Black has far less time
+        timer.start(limits, Color::Black);
+        EXPECT_LT(timer.hard(), 1000);
+
+        limits = SearchLimits();
+        limits.infinite = true;
+        timer.start(limits, Color::White);
+        EXPECT_FALSE(timer.timed());
+    }
+}
@@ -0,0 +1,101 @@
+// Written by Paul Baxter
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "bitboard.h"
+#include "evalcache.h"
+#include "tt.h"
+
+namespace tt_unit_test
+{
+    TEST(tt_unit_test, table_sizes)
+    {
+        EXPECT_EQ(floorPow2(0), 1u);
+        EXPECT_EQ(floorPow2(1), 1u);
+        EXPECT_EQ(floorPow2(1000), 512u);
+        EXPECT_EQ(floorPow2(1024), 1024u);
+    }
+
+    TEST(tt_unit_test, store_and_probe)
+    {
+        TranspositionTable tt(1);
+        uint64_t key = 0x123456789abcdef0ULL;
+        PackedMove move(12, 28, PackedMove::DoublePush);
+
+        TTEntry entry;
+        EXPECT_FALSE(tt.probe(key, entry));
+
+        tt.store(key, move, -4321, 7, TTFlag::Lower);
+        ASSERT_TRUE(tt.probe(key, entry));
+        EXPECT_EQ(entry.move, move);
+        EXPECT_EQ(entry.score, -4321);
+        EXPECT_EQ(entry.depth, 7);
+        EXPECT_EQ(entry.flag, TTFlag::Lower);
+
+        // Same bucket, different key
+        EXPECT_FALSE(tt.probe(key ^ (1ULL << 63), entry));
+
+        tt.clear();
+        EXPECT_FALSE(tt.probe(key, entry));
+    }
+
+    TEST(tt_unit_test, keeps_move_on_fail_low)
+    {
+        TranspositionTable tt(1);
+        uint64_t key = 42;
+        PackedMove move(6, 21);
+
+        tt.store(key, move, 10, 3, TTFlag::Exact);
+        tt.store(key, PackedMove{}, -5, 4, TTFlag::Upper);
+
+        TTEntry entry;
+        ASSERT_TRUE(tt.probe(key, entry));
+        EXPECT_EQ(entry.move, move);
+        EXPECT_EQ(entry.depth, 4);
+        EXPECT_EQ(entry.flag, TTFlag::Upper);
+    }
+
+    TEST(tt_unit_test, depth_preferred_replacement)
+    {
+        TranspositionTable tt(1);
+        uint64_t stride = tt.bucketCount();
+
+        // Fill one bucket, then store a fifth key mapping to it
+        for (int i = 0; i < 4; ++i)
+            tt.store(1 + stride * i, PackedMove{}, 0, 10 + i, TTFlag::Exact);
+        tt.store(1 + stride * 4, PackedMove{}, 0, 5, TTFlag::Exact);
+
+        // The shallowest entry made way
+        TTEntry entry;
+        EXPECT_FALSE(tt.probe(1, entry));
+        for (int i = 1; i <= 4; ++i)
+            EXPECT_TRUE(tt.probe(1 + stride * i, entry));
+
+        // Entries from an old search count as shallower than they are, so
+        // fresh entries push them out before each other
+        tt.newSearch();
+        tt.store(1 + stride * 5, PackedMove{}, 0, 6, TTFlag::Exact);
+        tt.store(1 + stride * 6, PackedMove{}, 0, 6, TTFlag::Exact);
+        EXPECT_TRUE(tt.probe(1 + stride * 5, entry));
+        EXPECT_TRUE(tt.probe(1 + stride * 6, entry));
+        EXPECT_EQ(entry.generation, tt.currentGeneration());
+    }
+
+    TEST(tt_unit_test, eval_cache)
+    {
+        EvalCache cache(1);
+        EXPECT_EQ(cache.entryCount(), 64u);
+
+        int64_t score = 0;
+        EXPECT_FALSE(cache.probe(0x1234, score));
+        cache.store(0x1234, -57);
+        ASSERT_TRUE(cache.probe(0x1234, score));
+        EXPECT_EQ(score, -57);
+
+        // Same slot, different key: the newer position replaces the older
+        cache.store(0x1234 + 64, 12);
+        EXPECT_FALSE(cache.probe(0x1234, score));
+        EXPECT_EQ(cache.probes(), 3u);
+        EXPECT_EQ(cache.hits(), 1u);
+    }
+}
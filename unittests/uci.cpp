@@ -0,0 +1,130 @@
+// Written by Paul Baxter
+#include <gtest/gtest.h>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "board.h"
+#include "engine.h"
+#include "uci.h"
+
+namespace uci_unit_test
+{
+    // Output buffer that the test can read while the search thread writes
+    class LockedBuffer : public std::stringbuf {
+    public:
+        std::string contents()
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            return str();
+        }
+
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            return std::stringbuf::overflow(ch);
+        }
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            return std::stringbuf::xsputn(s, n);
+        }
+
+    private:
+        std::recursive_mutex mutex;
+    };
+
+    static size_t count(const std::string& text, const std::string& what)
+    {
+        size_t n = 0;
+        for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1))
+            ++n;
+        return n;
+    }
+
+    TEST(uci_unit_test, position_with_moves)
+    {
+        std::istringstream in;
+        std::ostringstream out;
+        Uci uci(in, out);
+
+        uci.execute("position startpos moves e2e4 e7e5 g1f3");
+        Board expected("rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2");
+        EXPECT_TRUE(uci.position() == expected);
+
+        uci.execute("position fen 4k3/1P6/8/8/8/8/8/4K3 w - - 0 1 moves b7b8q");
+        EXPECT_EQ(uci.position().pieceOn(57).type, PieceType::Queen);
+
+        EXPECT_TRUE(Uci::parseMove(Board(), "e2e5").isNull());
+        EXPECT_EQ(Uci::formatScore(Engine::MATE_SCORE - 3), "mate 2");
+        EXPECT_EQ(Uci::formatScore(-Engine::MATE_SCORE + 2), "mate -1");
+        EXPECT_EQ(Uci::formatScore(-35), "cp -35");
+    }
+
+    TEST(uci_unit_test, go_depth_reports)
+    {
+        std::istringstream in;
+        std::ostringstream out;
+        Uci uci(in, out);
+
+        uci.execute("uci");
+        uci.execute("setoption name Threads value 2");
+        uci.execute("position fen 6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+        uci.execute("go depth 3");
+        uci.waitForSearch();
+
+        auto text = out.str();
+        EXPECT_NE(text.find("uciok"), std::string::npos);
+        EXPECT_NE(text.find("score mate 1 "), std::string::npos);
+        EXPECT_NE(text.find("bestmove a1a8"), std::string::npos);
+    }
+
+    TEST(uci_unit_test, infinite_waits_for_stop)
+    {
+        LockedBuffer buffer;
+        std::istringstream in;
+        std::ostream out(&buffer);
+        Uci uci(in, out);
+
+        // The depth runs out at once, but bestmove must wait for stop
+        uci.execute("position startpos");
+        uci.execute("go infinite depth 2");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        uci.execute("isready");
+        auto before = buffer.contents();
+        EXPECT_NE(before.find("readyok"), std::string::npos);
+        EXPECT_EQ(before.find("bestmove"), std::string::npos);
+
+        uci.execute("stop");
+        uci.waitForSearch();
+        EXPECT_EQ(count(buffer.contents(), "bestmove"), 1u);
+    }
+
+    TEST(uci_unit_test, no_moves_waits_for_stop)
+    {
+        LockedBuffer buffer;
+        std::istringstream in;
+        std::ostream out(&buffer);
+        Uci uci(in, out);
+
+        // Checkmated: there is nothing to search, yet go infinite and go
+        // ponder still answer only after stop or ponderhit
+        uci.execute("position fen 7k/6Q1/6K1/8/8/8/8/8 b - - 0 1");
+        uci.execute("go infinite");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(buffer.contents().find("bestmove"), std::string::npos);
+        uci.execute("stop");
+        uci.waitForSearch();
+        EXPECT_EQ(count(buffer.contents(), "bestmove 0000"), 1u);
+
+        uci.execute("go ponder wtime 1000 btime 1000");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(count(buffer.contents(), "bestmove"), 1u);
+        uci.execute("ponderhit");
+        uci.waitForSearch();
+        EXPECT_EQ(count(buffer.contents(), "bestmove"), 2u);
+    }
+}
@@ -120,4 +120,14 @@ namespace move_unit_test
         return filteredMoves;
     }
 
+    void AddPawnMove(std::vector<Move>& moves, Square from, Square to)
+    {
+        if (to.y != 0 && to.y != 7) {
+            moves.emplace_back(from, to);
+            return;
+        }
+        for (auto pt : { PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight })
+            moves.emplace_back(from, to, MoveType::Promotion, pt);
+    }
+
 }
\ No newline at end of file
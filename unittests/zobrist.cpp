@@ -0,0 +1,153 @@
+// Written by Paul Baxter
+#include <gtest/gtest.h>
+#include <string>
+#include <stdint.h>
+
+#include "board.h"
+
+namespace zobrist_unit_test
+{
+    // Walks the move tree checking the running key against a full
+    // recomputation at every node, and that undo restores it.
+    static void walk(Board& board, int depth)
+    {
+        ASSERT_EQ(board.zobristHash(), board.computeZobristHash());
+        ASSERT_EQ(board.pawnHash(), board.computePawnHash());
+        if (depth == 0)
+            return;
+
+        MoveList moves;
+        board.generateLegalMoves(board.getTurn(), moves);
+        auto before = board.zobristHash();
+        for (auto move : moves) {
+            board.makeMove(move);
+            walk(board, depth - 1);
+            board.undoMove();
+            ASSERT_EQ(board.zobristHash(), before);
+        }
+    }
+
+    TEST(zobrist_unit_test, incremental_matches_full)
+    {
+        for (auto fen : {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1" }) {
+            Board board(fen);
+            walk(board, 3);
+        }
+    }
+
+    TEST(zobrist_unit_test, transpositions_share_key)
+    {
+        Board a;
+        a.makeMove(Move({ 6, 0 }, { 5, 2 }));   // Nf3
+        a.makeMove(Move({ 6, 7 }, { 5, 5 }));   // Nf6
+        a.makeMove(Move({ 1, 0 }, { 2, 2 }));   // Nc3
+
+        Board b;
+        b.makeMove(Move({ 1, 0 }, { 2, 2 }));   // Nc3
+        b.makeMove(Move({ 6, 7 }, { 5, 5 }));   // Nf6
+        b.makeMove(Move({ 6, 0 }, { 5, 2 }));   // Nf3
+
+        EXPECT_EQ(a.zobristHash(), b.zobristHash());
+    }
+
+    TEST(zobrist_unit_test, set_turn_updates_key)
+    {
+        Board board;
+        auto white = board.zobristHash();
+        board.setTurn(Color::Black);
+        EXPECT_NE(board.zobristHash(), white);
+        EXPECT_EQ(board.zobristHash(), board.computeZobristHash());
+        board.setTurn(Color::White);
+        EXPECT_EQ(board.zobristHash(), white);
+    }
+
+    TEST(zobrist_unit_test, null_move_round_trip)
+    {
+        Board board("rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2");
+        board.makeMove(Move({ 5, 6 }, { 5, 4 }));   // f5, e.p. possible
+        Position before = board.position();
+
+        board.makeNullMove();
+        EXPECT_EQ(board.getTurn(), Color::Black);
+        EXPECT_EQ(board.enPassantTarget.x, -1);
+        EXPECT_EQ(board.zobristHash(), board.computeZobristHash());
+
+        board.undoMove();
+        EXPECT_TRUE(board.position() == before);
+    }
+
+    TEST(zobrist_unit_test, repetition_since_irreversible)
+    {
+        Board board;
+        const PackedMove shuffle[] = {
+            PackedMove(6, 21), PackedMove(62, 45),    // Nf3 Nf6
+            PackedMove(21, 6), PackedMove(45, 62) };  // Ng1 Ng8
+        for (int i = 0; i < 3; ++i) {
+            board.makeMove(shuffle[i]);
+            EXPECT_FALSE(board.isRepetition());
+        }
+        board.makeMove(shuffle[3]);
+        EXPECT_TRUE(board.isRepetition());
+        EXPECT_TRUE(board.isDraw());
+        EXPECT_EQ(board.keys().size(), 4u);
+
+        board.undoMove();
+        EXPECT_FALSE(board.isRepetition());
+        EXPECT_EQ(board.keys().size(), 3u);
+
+        // Shuffling after a pawn move does not reach back past it
+        board.loadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        board.makeMove(shuffle[0]);
+        board.makeMove(shuffle[1]);
+        board.makeMove(shuffle[2]);
+        board.makeMove(PackedMove(55, 47));       // h6
+        EXPECT_FALSE(board.isRepetition());
+
+        // The keys carry over to a board that only has the position
+        board.undoMove();
+        Board copy;
+        copy.setPosition(board.position(), board.keys());
+        copy.makeMove(shuffle[3]);
+        EXPECT_TRUE(copy.isRepetition());
+        Board bare(board.position());
+        bare.makeMove(shuffle[3]);
+        EXPECT_FALSE(bare.isRepetition());
+
+        board.loadFEN("7k/8/8/8/8/8/8/KQ6 w - - 100 80");
+        EXPECT_TRUE(board.isDraw());
+    }
+
+    TEST(zobrist_unit_test, null_move_and_draws)
+    {
+        // The fifty-move count runs on through a null move
+        Board board("4k3/8/8/8/8/8/8/R3K3 w - - 98 60");
+        board.makeNullMove();
+        EXPECT_EQ(board.halfMoveClock, 99);
+        board.makeMove(PackedMove(60, 59));   // Kd8
+        EXPECT_TRUE(board.isDraw());
+        board.undoMove();
+        board.undoMove();
+        EXPECT_EQ(board.halfMoveClock, 98);
+
+        // Kd1 and Ke1 with Black passing both times is back at the start,
+        // but a null move stands between them
+        board.loadFEN("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+        auto start = board.zobristHash();
+        board.makeMove(PackedMove(4, 3));
+        board.makeNullMove();
+        board.makeMove(PackedMove(3, 4));
+        board.makeNullMove();
+        EXPECT_EQ(board.zobristHash(), start);
+        EXPECT_EQ(board.halfMoveClock, 4);
+        EXPECT_FALSE(board.isRepetition());
+
+        // Without the null moves it is
+        board.loadFEN("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+        for (auto move : { PackedMove(4, 3), PackedMove(60, 59), PackedMove(3, 4), PackedMove(59, 60) })
+            board.makeMove(move);
+        EXPECT_TRUE(board.isRepetition());
+    }
+}